@@ -0,0 +1,597 @@
+#include "expr.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXPR_MAX_NODES 256
+#define EXPR_MAX_INSTRUCTIONS 256
+
+typedef enum {
+    OP_CONST,
+    OP_X,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    // Операции с константой imm вместо второго регистра
+    OP_ADDC,
+    OP_MULC,
+    OP_RSUBC,
+    OP_RDIVC,
+    OP_POWC,
+    // Слитые операции
+    OP_SQR,
+    OP_FMA,
+    OP_EXP,
+    OP_LOG,
+    OP_SQRT,
+    OP_SIN,
+    OP_COS,
+    OP_TAN,
+    OP_ATAN,
+    OP_SINH,
+    OP_COSH,
+    OP_TANH,
+    OP_ABS
+} expr_op;
+
+typedef struct {
+    expr_op op;
+    int args[3];
+    double value;
+} expr_node;
+
+typedef struct {
+    unsigned char op;
+    unsigned char dst;
+    unsigned char args[3];
+    double imm;
+} expr_instruction;
+
+struct expr_program {
+    expr_instruction code[EXPR_MAX_INSTRUCTIONS];
+    int length;
+    int result;
+};
+
+typedef struct {
+    const char *text;
+    const char *p;
+    expr_node nodes[EXPR_MAX_NODES];
+    int count;
+    char *error;
+    size_t error_size;
+    int failed;
+} expr_parser;
+
+typedef struct {
+    const char *name;
+    expr_op op;
+} expr_function;
+
+static const expr_function functions[] = {
+        {"exp",  OP_EXP},
+        {"log",  OP_LOG},
+        {"sqrt", OP_SQRT},
+        {"sin",  OP_SIN},
+        {"cos",  OP_COS},
+        {"tan",  OP_TAN},
+        {"atan", OP_ATAN},
+        {"sinh", OP_SINH},
+        {"cosh", OP_COSH},
+        {"tanh", OP_TANH},
+        {"abs",  OP_ABS}
+};
+
+static void fail(expr_parser *parser, const char *format, ...) {
+    if (parser->failed)
+        return;
+    parser->failed = 1;
+    int written = snprintf(parser->error, parser->error_size, "position %d: ", (int) (parser->p - parser->text));
+    if (written < 0 || (size_t) written >= parser->error_size)
+        return;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(parser->error + written, parser->error_size - written, format, args);
+    va_end(args);
+}
+
+static int add_node(expr_parser *parser, expr_op op, int arg0, int arg1, int arg2, double value) {
+    if (parser->count == EXPR_MAX_NODES) {
+        fail(parser, "expression is too long");
+        return 0;
+    }
+    expr_node *node = &parser->nodes[parser->count];
+    node->op = op;
+    node->args[0] = arg0;
+    node->args[1] = arg1;
+    node->args[2] = arg2;
+    node->value = value;
+    return parser->count++;
+}
+
+static int is_const(const expr_parser *parser, int node) {
+    return parser->nodes[node].op == OP_CONST;
+}
+
+static double const_value(const expr_parser *parser, int node) {
+    return parser->nodes[node].value;
+}
+
+static int same_tree(const expr_parser *parser, int left, int right) {
+    const expr_node *l = &parser->nodes[left];
+    const expr_node *r = &parser->nodes[right];
+    if (l->op != r->op || l->value != r->value)
+        return 0;
+    switch (l->op) {
+        case OP_CONST:
+        case OP_X:
+            return 1;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_POW:
+            return same_tree(parser, l->args[0], r->args[0]) && same_tree(parser, l->args[1], r->args[1]);
+        case OP_FMA:
+            return same_tree(parser, l->args[0], r->args[0]) && same_tree(parser, l->args[1], r->args[1]) &&
+                   same_tree(parser, l->args[2], r->args[2]);
+        default:
+            return same_tree(parser, l->args[0], r->args[0]);
+    }
+}
+
+static double apply_unary(expr_op op, double a, double imm) {
+    switch (op) {
+        case OP_ADDC:
+            return a + imm;
+        case OP_MULC:
+            return a * imm;
+        case OP_RSUBC:
+            return imm - a;
+        case OP_RDIVC:
+            return imm / a;
+        case OP_POWC:
+            return pow(a, imm);
+        case OP_SQR:
+            return a * a;
+        case OP_EXP:
+            return exp(a);
+        case OP_LOG:
+            return log(a);
+        case OP_SQRT:
+            return sqrt(a);
+        case OP_SIN:
+            return sin(a);
+        case OP_COS:
+            return cos(a);
+        case OP_TAN:
+            return tan(a);
+        case OP_ATAN:
+            return atan(a);
+        case OP_SINH:
+            return sinh(a);
+        case OP_COSH:
+            return cosh(a);
+        case OP_TANH:
+            return tanh(a);
+        default:
+            return fabs(a);
+    }
+}
+
+static int make_const(expr_parser *parser, double value) {
+    return add_node(parser, OP_CONST, 0, 0, 0, value);
+}
+
+// Узел с одним аргументом; константы сворачиваются сразу
+static int make_unary(expr_parser *parser, expr_op op, int arg, double imm) {
+    if (is_const(parser, arg))
+        return make_const(parser, apply_unary(op, const_value(parser, arg), imm));
+    if (op == OP_MULC && parser->nodes[arg].op == OP_MULC)
+        return make_unary(parser, OP_MULC, parser->nodes[arg].args[0], parser->nodes[arg].value * imm);
+    if (op == OP_MULC && imm == 1.0)
+        return arg;
+    if (op == OP_ADDC && imm == 0.0)
+        return arg;
+    return add_node(parser, op, arg, 0, 0, imm);
+}
+
+// Узел с двумя аргументами; операции с константой заменяются на варианты с imm, a * b + c - на FMA
+static int make_binary(expr_parser *parser, expr_op op, int left, int right) {
+    int left_const = is_const(parser, left);
+    int right_const = is_const(parser, right);
+    double l = left_const ? const_value(parser, left) : 0.0;
+    double r = right_const ? const_value(parser, right) : 0.0;
+    switch (op) {
+        case OP_ADD:
+            if (left_const && right_const)
+                return make_const(parser, l + r);
+            if (left_const)
+                return make_unary(parser, OP_ADDC, right, l);
+            if (right_const)
+                return make_unary(parser, OP_ADDC, left, r);
+            if (parser->nodes[left].op == OP_MUL)
+                return add_node(parser, OP_FMA, parser->nodes[left].args[0], parser->nodes[left].args[1], right, 0.0);
+            if (parser->nodes[right].op == OP_MUL)
+                return add_node(parser, OP_FMA, parser->nodes[right].args[0], parser->nodes[right].args[1], left, 0.0);
+            break;
+        case OP_SUB:
+            if (left_const && right_const)
+                return make_const(parser, l - r);
+            if (left_const)
+                return make_unary(parser, OP_RSUBC, right, l);
+            if (right_const)
+                return make_unary(parser, OP_ADDC, left, -r);
+            break;
+        case OP_MUL:
+            if (left_const && right_const)
+                return make_const(parser, l * r);
+            if (left_const)
+                return make_unary(parser, OP_MULC, right, l);
+            if (right_const)
+                return make_unary(parser, OP_MULC, left, r);
+            if (same_tree(parser, left, right))
+                return make_unary(parser, OP_SQR, left, 0.0);
+            break;
+        case OP_DIV:
+            if (left_const && right_const)
+                return make_const(parser, l / r);
+            if (left_const)
+                return make_unary(parser, OP_RDIVC, right, l);
+            if (right_const)
+                return make_unary(parser, OP_MULC, left, 1.0 / r);
+            break;
+        case OP_POW:
+            if (left_const && right_const)
+                return make_const(parser, pow(l, r));
+            if (right_const) {
+                if (r == 1.0)
+                    return left;
+                if (r == 2.0)
+                    return make_unary(parser, OP_SQR, left, 0.0);
+                if (r == 0.5)
+                    return make_unary(parser, OP_SQRT, left, 0.0);
+                return make_unary(parser, OP_POWC, left, r);
+            }
+            break;
+        default:
+            break;
+    }
+    return add_node(parser, op, left, right, 0, 0.0);
+}
+
+static void skip_spaces(expr_parser *parser) {
+    while (isspace((unsigned char) *parser->p))
+        parser->p++;
+}
+
+static int accept(expr_parser *parser, char c) {
+    skip_spaces(parser);
+    if (*parser->p != c)
+        return 0;
+    parser->p++;
+    return 1;
+}
+
+static void expect(expr_parser *parser, char c) {
+    if (!accept(parser, c))
+        fail(parser, "expected '%c'", c);
+}
+
+static int parse_sum(expr_parser *parser);
+
+static int parse_unary(expr_parser *parser);
+
+static int parse_primary(expr_parser *parser) {
+    skip_spaces(parser);
+    const char *start = parser->p;
+    if (isdigit((unsigned char) *start) || *start == '.') {
+        char *end;
+        double value = strtod(start, &end);
+        parser->p = end;
+        return make_const(parser, value);
+    }
+    if (accept(parser, '(')) {
+        int node = parse_sum(parser);
+        expect(parser, ')');
+        return node;
+    }
+    if (!isalpha((unsigned char) *start)) {
+        fail(parser, *start ? "unexpected '%c'" : "unexpected end of expression", *start);
+        return 0;
+    }
+    while (isalnum((unsigned char) *parser->p) || *parser->p == '_')
+        parser->p++;
+    size_t length = parser->p - start;
+    if (length == 1 && *start == 'x')
+        return add_node(parser, OP_X, 0, 0, 0, 0.0);
+    if (length == 2 && strncmp(start, "pi", 2) == 0)
+        return make_const(parser, 3.14159265358979323846);
+    if (length == 1 && *start == 'e')
+        return make_const(parser, 2.71828182845904523536);
+    if (length == 3 && strncmp(start, "pow", 3) == 0) {
+        expect(parser, '(');
+        int base = parse_sum(parser);
+        expect(parser, ',');
+        int exponent = parse_sum(parser);
+        expect(parser, ')');
+        return make_binary(parser, OP_POW, base, exponent);
+    }
+    for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+        if (strlen(functions[i].name) == length && strncmp(start, functions[i].name, length) == 0) {
+            expect(parser, '(');
+            int arg = parse_sum(parser);
+            expect(parser, ')');
+            return make_unary(parser, functions[i].op, arg, 0.0);
+        }
+    parser->p = start;
+    fail(parser, "unknown identifier '%.*s'", (int) length, start);
+    return 0;
+}
+
+static int parse_power(expr_parser *parser) {
+    int base = parse_primary(parser);
+    if (accept(parser, '^'))
+        return make_binary(parser, OP_POW, base, parse_unary(parser));
+    return base;
+}
+
+static int parse_unary(expr_parser *parser) {
+    if (accept(parser, '-'))
+        return make_unary(parser, OP_MULC, parse_unary(parser), -1.0);
+    if (accept(parser, '+'))
+        return parse_unary(parser);
+    return parse_power(parser);
+}
+
+static int parse_product(expr_parser *parser) {
+    int node = parse_unary(parser);
+    while (!parser->failed) {
+        if (accept(parser, '*'))
+            node = make_binary(parser, OP_MUL, node, parse_unary(parser));
+        else if (accept(parser, '/'))
+            node = make_binary(parser, OP_DIV, node, parse_unary(parser));
+        else
+            break;
+    }
+    return node;
+}
+
+static int parse_sum(expr_parser *parser) {
+    int node = parse_product(parser);
+    while (!parser->failed) {
+        if (accept(parser, '+'))
+            node = make_binary(parser, OP_ADD, node, parse_product(parser));
+        else if (accept(parser, '-'))
+            node = make_binary(parser, OP_SUB, node, parse_product(parser));
+        else
+            break;
+    }
+    return node;
+}
+
+typedef struct {
+    expr_parser *parser;
+    expr_program *program;
+    unsigned used;
+} expr_compiler;
+
+// Регистр 0 всегда содержит x; результаты узлов занимают свободные регистры и освобождаются после использования
+static int allocate_register(expr_compiler *compiler) {
+    for (int reg = 1; reg < EXPR_MAX_REGISTERS; reg++)
+        if (!(compiler->used & (1u << reg))) {
+            compiler->used |= 1u << reg;
+            return reg;
+        }
+    fail(compiler->parser, "expression needs more than %d registers", EXPR_MAX_REGISTERS);
+    return 1;
+}
+
+static void release_register(expr_compiler *compiler, int reg) {
+    if (reg != 0)
+        compiler->used &= ~(1u << reg);
+}
+
+static int arity(expr_op op) {
+    switch (op) {
+        case OP_CONST:
+        case OP_X:
+            return 0;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_POW:
+            return 2;
+        case OP_FMA:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+static int emit(expr_compiler *compiler, int node_index) {
+    const expr_node *node = &compiler->parser->nodes[node_index];
+    if (node->op == OP_X)
+        return 0;
+    int args[3] = {0, 0, 0};
+    int count = arity(node->op);
+    for (int i = 0; i < count; i++)
+        args[i] = emit(compiler, node->args[i]);
+    for (int i = 0; i < count; i++)
+        release_register(compiler, args[i]);
+    int dst = allocate_register(compiler);
+    expr_program *program = compiler->program;
+    if (program->length == EXPR_MAX_INSTRUCTIONS) {
+        fail(compiler->parser, "expression is too long");
+        return dst;
+    }
+    expr_instruction *instruction = &program->code[program->length++];
+    instruction->op = (unsigned char) node->op;
+    instruction->dst = (unsigned char) dst;
+    for (int i = 0; i < 3; i++)
+        instruction->args[i] = (unsigned char) args[i];
+    instruction->imm = node->value;
+    return dst;
+}
+
+expr_program *expr_compile(const char *text, char *error, size_t error_size) {
+    expr_parser *parser = (expr_parser *) calloc(1, sizeof(*parser));
+    expr_program *program = (expr_program *) calloc(1, sizeof(*program));
+    parser->text = text;
+    parser->p = text;
+    parser->error = error;
+    parser->error_size = error_size;
+    int root = parse_sum(parser);
+    skip_spaces(parser);
+    if (!parser->failed && *parser->p != '\0')
+        fail(parser, "unexpected '%c'", *parser->p);
+    if (!parser->failed) {
+        expr_compiler compiler = {parser, program, 1u};
+        program->result = emit(&compiler, root);
+    }
+    int failed = parser->failed;
+    free(parser);
+    if (failed) {
+        free(program);
+        return NULL;
+    }
+    return program;
+}
+
+void expr_free(expr_program *program) {
+    free(program);
+}
+
+int expr_length(const expr_program *program) {
+    return program->length;
+}
+
+void expr_eval(const expr_program *program, const double *x, double *y, int count) {
+    double registers[EXPR_MAX_REGISTERS][EXPR_BLOCK];
+    double *r[EXPR_MAX_REGISTERS];
+    r[0] = (double *) x;
+    for (int i = 1; i < EXPR_MAX_REGISTERS; i++)
+        r[i] = registers[i];
+    for (int k = 0; k < program->length; k++) {
+        const expr_instruction *in = &program->code[k];
+        double *d = r[in->dst];
+        const double *a = r[in->args[0]];
+        const double *b = r[in->args[1]];
+        const double *c = r[in->args[2]];
+        double imm = in->imm;
+        switch ((expr_op) in->op) {
+            case OP_CONST:
+                for (int i = 0; i < count; i++)
+                    d[i] = imm;
+                break;
+            case OP_ADD:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] + b[i];
+                break;
+            case OP_SUB:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] - b[i];
+                break;
+            case OP_MUL:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] * b[i];
+                break;
+            case OP_DIV:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] / b[i];
+                break;
+            case OP_POW:
+                for (int i = 0; i < count; i++)
+                    d[i] = pow(a[i], b[i]);
+                break;
+            case OP_ADDC:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] + imm;
+                break;
+            case OP_MULC:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] * imm;
+                break;
+            case OP_RSUBC:
+                for (int i = 0; i < count; i++)
+                    d[i] = imm - a[i];
+                break;
+            case OP_RDIVC:
+                for (int i = 0; i < count; i++)
+                    d[i] = imm / a[i];
+                break;
+            case OP_POWC:
+                for (int i = 0; i < count; i++)
+                    d[i] = pow(a[i], imm);
+                break;
+            case OP_SQR:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] * a[i];
+                break;
+            case OP_FMA:
+                for (int i = 0; i < count; i++)
+                    d[i] = a[i] * b[i] + c[i];
+                break;
+            case OP_EXP:
+                for (int i = 0; i < count; i++)
+                    d[i] = exp(a[i]);
+                break;
+            case OP_LOG:
+                for (int i = 0; i < count; i++)
+                    d[i] = log(a[i]);
+                break;
+            case OP_SQRT:
+                for (int i = 0; i < count; i++)
+                    d[i] = sqrt(a[i]);
+                break;
+            case OP_SIN:
+                for (int i = 0; i < count; i++)
+                    d[i] = sin(a[i]);
+                break;
+            case OP_COS:
+                for (int i = 0; i < count; i++)
+                    d[i] = cos(a[i]);
+                break;
+            case OP_TAN:
+                for (int i = 0; i < count; i++)
+                    d[i] = tan(a[i]);
+                break;
+            case OP_ATAN:
+                for (int i = 0; i < count; i++)
+                    d[i] = atan(a[i]);
+                break;
+            case OP_SINH:
+                for (int i = 0; i < count; i++)
+                    d[i] = sinh(a[i]);
+                break;
+            case OP_COSH:
+                for (int i = 0; i < count; i++)
+                    d[i] = cosh(a[i]);
+                break;
+            case OP_TANH:
+                for (int i = 0; i < count; i++)
+                    d[i] = tanh(a[i]);
+                break;
+            case OP_ABS:
+                for (int i = 0; i < count; i++)
+                    d[i] = fabs(a[i]);
+                break;
+            case OP_X:
+                break;
+        }
+    }
+    memcpy(y, r[program->result], sizeof(*y) * count);
+}
+
+double expr_eval_scalar(const expr_program *program, double x) {
+    double y;
+    expr_eval(program, &x, &y, 1);
+    return y;
+}
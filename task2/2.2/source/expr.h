@@ -0,0 +1,25 @@
+#ifndef EXPR_H
+#define EXPR_H
+
+#include <stddef.h>
+
+// Количество значений x, обрабатываемых интерпретатором за одну инструкцию
+#define EXPR_BLOCK 256
+#define EXPR_MAX_REGISTERS 16
+
+typedef struct expr_program expr_program;
+
+// Разбирает выражение от x (например "exp(-x*x)") и компилирует его в регистровый байткод.
+// При ошибке возвращает NULL и записывает описание в error.
+expr_program *expr_compile(const char *text, char *error, size_t error_size);
+
+void expr_free(expr_program *program);
+
+// y[i] = f(x[i]) для count <= EXPR_BLOCK значений; потокобезопасно
+void expr_eval(const expr_program *program, const double *x, double *y, int count);
+
+double expr_eval_scalar(const expr_program *program, double x);
+
+int expr_length(const expr_program *program);
+
+#endif
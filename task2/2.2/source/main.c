@@ -3,11 +3,42 @@
 #include <time.h>
 #include <omp.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "expr.h"
+
+typedef enum {
+    RULE_MIDPOINT,
+    RULE_TRAPEZOID,
+    RULE_SIMPSON
+} rule_t;
+
+// Подынтегральная функция: либо скомпилированная в программу функция func, либо выражение, заданное строкой
+typedef struct {
+    double (*func)(double);
+    const expr_program *program;
+} integrand_t;
 
 const double PI = 3.14159265358979323846;
-const double a = -4.0;
-const double b = 4.0;
-const int nsteps = 40000000;
+const char *rule_names[] = {"midpoint", "trapezoid", "simpson"};
+// Внутри блока индекс узла хранится 32-битным смещением от 64-битного начала блока
+const int64_t chunk_steps = (int64_t) 1 << 24;
+const int64_t repro_min_chunk = 4096;
+const int64_t repro_max_chunks = 65536;
+// 2^25 + 1 узлов последнего уровня - порядка числа шагов по умолчанию
+#define ROMBERG_MAX_LEVELS 25
+const int romberg_min_levels = 4;
+
+double func(double x);
+
+double a = -4.0;
+double b = 4.0;
+int64_t nsteps = 40000000;
+rule_t rule = RULE_MIDPOINT;
+integrand_t integrand = {func, NULL};
 
 double cpuSecond() {
     struct timespec ts;
@@ -19,59 +50,409 @@ double func(double x) {
     return exp(-x * x);
 }
 
-double integrate(double (*func)(double), double a, double b, int n) {
-    double h = (b - a) / n;
+double integrand_value(const integrand_t *f, double x) {
+    return f->program ? expr_eval_scalar(f->program, x) : f->func(x);
+}
+
+double progression_sum(double (*func)(double), double x0, double step, uint32_t count) {
+    double sum = 0.0;
+    for (uint32_t k = 0; k < count; k++)
+        sum += func(x0 + step * k);
+    return sum;
+}
+
+double progression_sum_kahan(double (*func)(double), double x0, double step, uint32_t count) {
+    double sum = 0.0;
+    double c = 0.0;
+    for (uint32_t k = 0; k < count; k++) {
+        double y = func(x0 + step * k) - c;
+        double t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    }
+    return sum;
+}
+
+// Выражение вычисляется блоками по EXPR_BLOCK значений x, чтобы каждая инструкция байткода обрабатывала весь блок
+double progression_sum_expr(const expr_program *program, double x0, double step, uint32_t count, int compensated) {
+    double xs[EXPR_BLOCK];
+    double ys[EXPR_BLOCK];
+    double sum = 0.0;
+    double c = 0.0;
+    for (uint32_t base = 0; base < count; base += EXPR_BLOCK) {
+        int block = (count - base < EXPR_BLOCK) ? (int) (count - base) : EXPR_BLOCK;
+        for (int i = 0; i < block; i++)
+            xs[i] = x0 + step * (base + i);
+        expr_eval(program, xs, ys, block);
+        if (compensated) {
+            for (int i = 0; i < block; i++) {
+                double y = ys[i] - c;
+                double t = sum + y;
+                c = (t - sum) - y;
+                sum = t;
+            }
+        } else {
+            for (int i = 0; i < block; i++)
+                sum += ys[i];
+        }
+    }
+    return sum;
+}
+
+double progression(const integrand_t *f, double x0, double step, uint32_t count, int compensated) {
+    if (f->program)
+        return progression_sum_expr(f->program, x0, step, count, compensated);
+    return compensated ? progression_sum_kahan(f->func, x0, step, count) : progression_sum(f->func, x0, step, count);
+}
+
+// Узлы квадратурной формулы, не лежащие на концах отрезка: [0, n - 1] для средних, [1, n - 1] для остальных
+int64_t first_node(rule_t rule) {
+    return rule == RULE_MIDPOINT ? 0 : 1;
+}
+
+int64_t last_node(int64_t n) {
+    return n - 1;
+}
+
+// Взвешенная сумма значений подынтегральной функции в узлах [lb, ub]
+double range_sum(const integrand_t *f, rule_t rule, double a, double h, int64_t lb, int64_t ub, int compensated) {
     double sum = 0.0;
-    for (int i = 0; i < n; i++)
-        sum += func(a + h * (i + 0.5));
-    sum *= h;
+    for (int64_t base = lb; base <= ub; base += chunk_steps) {
+        uint32_t count = (uint32_t) ((ub - base + 1 < chunk_steps) ? (ub - base + 1) : chunk_steps);
+        switch (rule) {
+            case RULE_MIDPOINT:
+                sum += progression(f, a + h * ((double) base + 0.5), h, count, compensated);
+                break;
+            case RULE_TRAPEZOID:
+                sum += progression(f, a + h * (double) base, h, count, compensated);
+                break;
+            case RULE_SIMPSON: {
+                // Нечётные узлы имеют вес 4, чётные - вес 2
+                uint32_t odd = (base & 1) ? 0 : 1;
+                uint32_t even = 1 - odd;
+                uint32_t odd_count = (count - odd + 1) / 2;
+                uint32_t even_count = (count - even + 1) / 2;
+                sum += 4.0 * progression(f, a + h * (double) (base + odd), 2.0 * h, odd_count, compensated);
+                sum += 2.0 * progression(f, a + h * (double) (base + even), 2.0 * h, even_count, compensated);
+                break;
+            }
+        }
+    }
     return sum;
 }
 
-double integrate_omp(double (*func)(double), double a, double b, int n, int threads) {
+// Добавляет вклад концов отрезка и множитель шага
+double finish_sum(const integrand_t *f, rule_t rule, double a, double b, double h, double sum) {
+    switch (rule) {
+        case RULE_TRAPEZOID:
+            return h * (sum + 0.5 * (integrand_value(f, a) + integrand_value(f, b)));
+        case RULE_SIMPSON:
+            return h / 3.0 * (sum + integrand_value(f, a) + integrand_value(f, b));
+        default:
+            return h * sum;
+    }
+}
+
+double integrate(const integrand_t *f, rule_t rule, double a, double b, int64_t n) {
     double h = (b - a) / n;
+    double sum = range_sum(f, rule, a, h, first_node(rule), last_node(n), 0);
+    return finish_sum(f, rule, a, b, h, sum);
+}
+
+double parallel_range_sum(const integrand_t *f, rule_t rule, double a, double h, int64_t first, int64_t last,
+                          int threads) {
     double sum = 0.0;
 #pragma omp parallel num_threads(threads)
     {
         int nthreads = omp_get_num_threads();
         int threadid = omp_get_thread_num();
-        int items_per_thread = n / nthreads;
-        int lb = threadid * items_per_thread;
-        int ub = (threadid == nthreads - 1) ? (n - 1) : (lb + items_per_thread - 1);
-        double sumlock = 0.0;
-        for (int i = lb; i <= ub; i++)
-            sumlock += func(a + h * (i + 0.5));
+        int64_t items_per_thread = (last - first + 1) / nthreads;
+        int64_t lb = first + threadid * items_per_thread;
+        int64_t ub = (threadid == nthreads - 1) ? last : (lb + items_per_thread - 1);
+        double sumlock = range_sum(f, rule, a, h, lb, ub, 0);
 #pragma omp atomic
         sum += sumlock;
     }
-    sum *= h;
     return sum;
 }
 
+double integrate_omp(const integrand_t *f, rule_t rule, double a, double b, int64_t n, int threads) {
+    double h = (b - a) / n;
+    double sum = parallel_range_sum(f, rule, a, h, first_node(rule), last_node(n), threads);
+    return finish_sum(f, rule, a, b, h, sum);
+}
+
+// Метод Ромберга на вложенных сетках: при удвоении числа шагов вычисляются только новые средние точки,
+// а сумма по старым узлам берётся из предыдущего уровня. Если за ROMBERG_MAX_LEVELS уровней точность tol
+// не достигнута, *converged = 0 и возвращается последний диагональный элемент таблицы
+double integrate_romberg(const integrand_t *f, double a, double b, double tol, int threads,
+                         int *levels, int64_t *evaluations, int *converged) {
+    double previous[ROMBERG_MAX_LEVELS + 1];
+    double current[ROMBERG_MAX_LEVELS + 1];
+    int64_t n = 1;
+    previous[0] = 0.5 * (b - a) * (integrand_value(f, a) + integrand_value(f, b));
+    *evaluations = 2;
+    *converged = 1;
+    for (int k = 1; k <= ROMBERG_MAX_LEVELS; k++) {
+        double h = (b - a) / n;
+        double midpoints = parallel_range_sum(f, RULE_MIDPOINT, a, h, 0, n - 1, threads);
+        *evaluations += n;
+        n *= 2;
+        current[0] = 0.5 * (previous[0] + h * midpoints);
+        double factor = 1.0;
+        for (int j = 1; j <= k; j++) {
+            factor *= 4.0;
+            current[j] = current[j - 1] + (current[j - 1] - previous[j - 1]) / (factor - 1.0);
+        }
+        *levels = k;
+        if (k >= romberg_min_levels && fabs(current[k] - previous[k - 1]) < tol)
+            return current[k];
+        for (int j = 0; j <= k; j++)
+            previous[j] = current[j];
+    }
+    *converged = 0;
+    return previous[ROMBERG_MAX_LEVELS];
+}
+
+// Сумма по фиксированному бинарному дереву: порядок сложения зависит только от count
+double pairwise_sum(const double *values, int64_t count) {
+    if (count == 1)
+        return values[0];
+    int64_t half = count / 2;
+    return pairwise_sum(values, half) + pairwise_sum(values + half, count - half);
+}
+
+// Разбиение на блоки зависит только от n, поэтому результат побитово совпадает при любом числе потоков
+double integrate_omp_reproducible(const integrand_t *f, rule_t rule, double a, double b, int64_t n, int threads,
+                                  int compensated) {
+    double h = (b - a) / n;
+    int64_t first = first_node(rule);
+    int64_t items = last_node(n) - first + 1;
+    int64_t chunk = (items + repro_max_chunks - 1) / repro_max_chunks;
+    if (chunk < repro_min_chunk)
+        chunk = repro_min_chunk;
+    int64_t nchunks = (items + chunk - 1) / chunk;
+    if (nchunks == 0)
+        return finish_sum(f, rule, a, b, h, 0.0);
+    double *partial = (double *) malloc(sizeof(*partial) * nchunks);
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (int64_t k = 0; k < nchunks; k++) {
+        int64_t lb = first + k * chunk;
+        int64_t ub = (k == nchunks - 1) ? (first + items - 1) : (lb + chunk - 1);
+        partial[k] = range_sum(f, rule, a, h, lb, ub, compensated);
+    }
+    double sum = pairwise_sum(partial, nchunks);
+    free(partial);
+    return finish_sum(f, rule, a, b, h, sum);
+}
+
+double exact() {
+    return sqrt(PI) / 2 * (erf(b) - erf(a));
+}
+
+// Точное значение известно только для встроенной функции exp(-x * x)
+void print_error(double res) {
+    if (integrand.program)
+        printf("\n");
+    else
+        printf("; error %.12f\n", fabs(res - exact()));
+}
+
 double run_serial() {
     double t = cpuSecond();
-    double res = integrate(func, a, b, nsteps);
+    double res = integrate(&integrand, rule, a, b, nsteps);
     t = cpuSecond() - t;
-    printf("Result (serial): %.12f; error %.12f\n", res, fabs(res - sqrt(PI)));
+    printf("Result (serial): %.12f", res);
+    print_error(res);
     return t;
 }
 
 double run_parallel(int threads) {
     double t = cpuSecond();
-    double res = integrate_omp(func, a, b, nsteps, threads);
+    double res = integrate_omp(&integrand, rule, a, b, nsteps, threads);
     t = cpuSecond() - t;
-    printf("Result (parallel): %.12f; error %.12f\n", res, fabs(res - sqrt(PI)));
+    printf("Result (parallel): %.12f", res);
+    print_error(res);
     return t;
 }
 
+double run_reproducible(int threads, int compensated) {
+    const char *name = compensated ? "reproducible, Kahan" : "reproducible";
+    double t = cpuSecond();
+    double res = integrate_omp_reproducible(&integrand, rule, a, b, nsteps, threads, compensated);
+    t = cpuSecond() - t;
+    printf("Result (%s): %.12f (%a)", name, res, res);
+    print_error(res);
+    double reference = integrate_omp_reproducible(&integrand, rule, a, b, nsteps, 1, compensated);
+    printf("Bitwise equal to 1-thread run (%s): %s\n", name, res == reference ? "yes" : "no");
+    return t;
+}
+
+// 0 - точность достигнута, 1 - нет (сообщение в stderr)
+int run_romberg(int threads, double tol) {
+    int levels = 0;
+    int converged = 0;
+    int64_t evaluations = 0;
+    double t = cpuSecond();
+    double res = integrate_romberg(&integrand, a, b, tol, threads, &levels, &evaluations, &converged);
+    t = cpuSecond() - t;
+    int64_t final_nodes = ((int64_t) 1 << levels) + 1;
+    int64_t rerun_evaluations = 0;
+    for (int k = 0; k <= levels; k++)
+        rerun_evaluations += ((int64_t) 1 << k) + 1;
+    printf("Result (Romberg): %.12f", res);
+    print_error(res);
+    printf("Levels: %d; final grid: %" PRId64 " nodes\n", levels, final_nodes);
+    printf("Function evaluations: %" PRId64 " (independent reruns of every level: %" PRId64 ")\n",
+           evaluations, rerun_evaluations);
+    printf("Execution time (Romberg): %.6f\n", t);
+    if (!converged) {
+        fprintf(stderr, "Romberg did not reach tolerance %g in %d levels\n", tol, ROMBERG_MAX_LEVELS);
+        return 1;
+    }
+    return 0;
+}
+
+void run_expression_benchmark(int threads) {
+    char error[128];
+    expr_program *program = expr_compile("exp(-x*x)", error, sizeof(error));
+    integrand_t native = {func, NULL};
+    integrand_t compiled = {NULL, program};
+    double t = cpuSecond();
+    double res_native = integrate_omp(&native, rule, a, b, nsteps, threads);
+    double tnative = cpuSecond() - t;
+    t = cpuSecond();
+    double res_compiled = integrate_omp(&compiled, rule, a, b, nsteps, threads);
+    double tcompiled = cpuSecond() - t;
+    printf("Result (native exp(-x*x)): %.12f\n", res_native);
+    printf("Result (expression \"exp(-x*x)\", %d instructions): %.12f\n", expr_length(program), res_compiled);
+    printf("Execution time (native): %.6f\n", tnative);
+    printf("Execution time (expression): %.6f\n", tcompiled);
+    printf("Expression slowdown: %.2f\n", tcompiled / tnative);
+    expr_free(program);
+}
+
+int parse_steps(const char *text, int64_t *steps) {
+    char *end;
+    long long value = strtoll(text, &end, 10);
+    if (*end != '\0') {
+        // Допускается запись вида 1e11
+        double real = strtod(text, &end);
+        if (*end != '\0' || real != floor(real) || real > 9.0e18)
+            return 0;
+        value = (long long) real;
+    }
+    *steps = value;
+    return value > 0;
+}
+
+int parse_rule(const char *text, rule_t *result) {
+    for (size_t i = 0; i < sizeof(rule_names) / sizeof(rule_names[0]); i++)
+        if (strcmp(text, rule_names[i]) == 0) {
+            *result = (rule_t) i;
+            return 1;
+        }
+    return 0;
+}
+
+void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [threads] [-t threads] [-a a] [-b b] [-n nsteps] [-r midpoint|trapezoid|simpson] [-e tol]\n"
+                    "       [-f expression] [-B]\n",
+            name);
+}
+
 int main(int argc, char **argv) {
-    int threads = atoi(argv[1]);
-    printf("Integration f(x) on [%.12f, %.12f], nsteps = %d\n", a, b, nsteps);
+    int threads = omp_get_max_threads();
+    if (argc > 1 && argv[1][0] != '-') {
+        threads = atoi(argv[1]);
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+    }
+    double tol = 0.0;
+    int benchmark = 0;
+    const char *expression = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:a:b:n:r:e:f:B")) != -1) {
+        switch (opt) {
+            case 't':
+                threads = atoi(optarg);
+                break;
+            case 'a':
+                a = atof(optarg);
+                break;
+            case 'b':
+                b = atof(optarg);
+                break;
+            case 'n':
+                if (!parse_steps(optarg, &nsteps)) {
+                    fprintf(stderr, "Invalid number of steps: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                if (!parse_rule(optarg, &rule)) {
+                    fprintf(stderr, "Unknown rule: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'e':
+                tol = atof(optarg);
+                if (tol <= 0.0) {
+                    fprintf(stderr, "Invalid tolerance: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                expression = optarg;
+                break;
+            case 'B':
+                benchmark = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (threads < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (benchmark) {
+        printf("Integration f(x) on [%.12f, %.12f], nsteps = %" PRId64 ", rule = %s, threads = %d\n",
+               a, b, nsteps, rule_names[rule], threads);
+        run_expression_benchmark(threads);
+        return 0;
+    }
+    if (expression) {
+        char error[128];
+        integrand.program = expr_compile(expression, error, sizeof(error));
+        if (!integrand.program) {
+            fprintf(stderr, "Invalid expression: %s\n", error);
+            return 1;
+        }
+        printf("f(x) = %s (%d instructions)\n", expression, expr_length(integrand.program));
+    }
+    if (tol > 0.0) {
+        printf("Integration f(x) on [%.12f, %.12f], Romberg with tolerance %g, threads = %d\n", a, b, tol, threads);
+        return run_romberg(threads, tol);
+    }
+    if (rule == RULE_SIMPSON && nsteps % 2 != 0) {
+        fprintf(stderr, "Simpson's rule requires an even number of steps\n");
+        return 1;
+    }
+    printf("Integration f(x) on [%.12f, %.12f], nsteps = %" PRId64 ", rule = %s, threads = %d\n",
+           a, b, nsteps, rule_names[rule], threads);
     double tserial = run_serial();
     double tparallel = run_parallel(threads);
+    double treproducible = run_reproducible(threads, 0);
+    double tkahan = run_reproducible(threads, 1);
 
     printf("Execution time (serial): %.6f\n", tserial);
     printf("Execution time (parallel): %.6f\n", tparallel);
+    printf("Execution time (reproducible): %.6f\n", treproducible);
+    printf("Execution time (reproducible, Kahan): %.6f\n", tkahan);
     printf("Speedup: %.2f\n", tserial / tparallel);
+    printf("Reproducible overhead vs atomic: %.2f / %.2f\n", treproducible / tparallel, tkahan / tparallel);
     return 0;
-}
\ No newline at end of file
+}
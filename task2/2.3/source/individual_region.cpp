@@ -1,103 +1,665 @@
-#include <iostream>
 #include <vector>
 #include <cmath>
-#include <chrono>
+#include <string>
+#include <random>
+#include <algorithm>
 
-size_t N;
-size_t threads;
+#include "individual_region.hpp"
+#include "telemetry.hpp"
 
-void MatrixVectorProduct(const std::vector<double> &matrix, const std::vector<double> &vector,
+// Для операторов с доступом к строкам цикл по строкам записан здесь же с nowait, чтобы телеметрия
+// отделяла работу потока от ожидания; иначе ожидание остаётся внутри Apply и входит во время matvec
+void MatrixVectorProduct(const LinearOperator &matrix, const std::vector<double> &vector,
                          std::vector<double> &resultVector) {
-#if defined(SCHEDULE_DYNAMIC)
-#pragma omp parallel for num_threads(threads) schedule(dynamic)
-#elif defined(SCHEDULE_GUIDED)
-#pragma omp parallel for num_threads(threads) schedule(guided)
-#elif defined(SCHEDULE_AUTO)
-#pragma omp parallel for num_threads(threads) schedule(auto)
-#else
-#pragma omp parallel for num_threads(threads) schedule(static)
-#endif
-    for (int i = 0; i < N; ++i) {
-        resultVector[i] = 0;
-        for (int j = 0; j < N; ++j)
-            resultVector[i] += matrix[i * N + j] * vector[j];
+#pragma omp parallel num_threads(threads)
+    {
+        KernelTimer timer(Kernel::Matvec);
+        if (matrix.RowAccess()) {
+#pragma omp for schedule(runtime) nowait
+            for (int i = 0; i < N; ++i)
+                resultVector[i] = matrix.RowDot(i, vector);
+        } else
+            matrix.Apply(vector, resultVector);
+        timer.Barrier();
     }
 }
 
+void Precondition(const Preconditioner &M, const std::vector<double> &r, std::vector<double> &z) {
+#pragma omp parallel num_threads(threads)
+    M.Apply(r, z);
+}
+
 void VectorSubtraction(const std::vector<double> &vector0, const std::vector<double> &vector1,
-                       std::vector<double> &resultVector) {
-#if defined(SCHEDULE_DYNAMIC)
-#pragma omp parallel for num_threads(threads) schedule(dynamic)
-#elif defined(SCHEDULE_GUIDED)
-#pragma omp parallel for num_threads(threads) schedule(guided)
-#elif defined(SCHEDULE_AUTO)
-#pragma omp parallel for num_threads(threads) schedule(auto)
-#else
-#pragma omp parallel for num_threads(threads) schedule(static)
-#endif
-    for (int i = 0; i < N; ++i)
-        resultVector[i] = vector0[i] - vector1[i];
+                       std::vector<double> &resultVector, Kernel kernel = Kernel::Subtraction) {
+#pragma omp parallel num_threads(threads)
+    {
+        KernelTimer timer(kernel);
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < N; ++i)
+            resultVector[i] = vector0[i] - vector1[i];
+        timer.Barrier();
+    }
 }
 
 void ScalarVectorProduct(double scalar, const std::vector<double> &vector, std::vector<double> &resultVector) {
-    for (int i = 0; i < N; ++i)
-        resultVector[i] = scalar * vector[i];
+#pragma omp parallel num_threads(threads)
+    {
+        KernelTimer timer(Kernel::Update);
+#pragma omp for schedule(runtime) nowait
+        for (int i = 0; i < N; ++i)
+            resultVector[i] = scalar * vector[i];
+        timer.Barrier();
+    }
 }
 
 double Norm(const std::vector<double> &vector) {
     double norm{};
-#if defined(SCHEDULE_DYNAMIC)
-#pragma omp parallel for num_threads(threads) schedule(dynamic)
-#elif defined(SCHEDULE_GUIDED)
-#pragma omp parallel for num_threads(threads) schedule(guided)
-#elif defined(SCHEDULE_AUTO)
-#pragma omp parallel for num_threads(threads) schedule(auto)
-#else
-#pragma omp parallel for num_threads(threads) schedule(static)
-#endif
-    for (int i = 0; i < N; ++i)
-        norm += vector[i] * vector[i];
+#pragma omp parallel num_threads(threads)
+    {
+        KernelTimer timer(Kernel::Norm);
+#pragma omp for schedule(runtime) reduction(+:norm) nowait
+        for (int i = 0; i < N; ++i)
+            norm += vector[i] * vector[i];
+        timer.Barrier();
+    }
     return sqrt(norm);
 }
 
-void Algorithm(const std::vector<double> &A, const std::vector<double> &b, std::vector<double> &X, double tau) {
-    std::vector<double> bufferVector(N);
+double Dot(const std::vector<double> &vector0, const std::vector<double> &vector1) {
+    double result{};
+#pragma omp parallel for num_threads(threads) schedule(runtime) reduction(+:result)
+    for (int i = 0; i < N; ++i)
+        result += vector0[i] * vector1[i];
+    return result;
+}
+
+// vector1 = vector1 + scalar * vector0
+void Axpy(double scalar, const std::vector<double> &vector0, std::vector<double> &vector1) {
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+    for (int i = 0; i < N; ++i)
+        vector1[i] += scalar * vector0[i];
+}
+
+// vector1 = vector0 + scalar * vector1
+void Xpay(const std::vector<double> &vector0, double scalar, std::vector<double> &vector1) {
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+    for (int i = 0; i < N; ++i)
+        vector1[i] = vector0[i] + scalar * vector1[i];
+}
+
+// С предобусловливателем M шаг делается по M^-1 (AX - b), τ относится к спектру M^-1 A
+size_t Algorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X, double tau,
+                 const Preconditioner *M) {
+    std::vector<double> bufferVector(N), preconditioned(M ? N : 0);
+    std::vector<double> &step = M ? preconditioned : bufferVector;
+    size_t iterations{};
     while (true) {
         MatrixVectorProduct(A, X, bufferVector);
+        ++iterations;
         VectorSubtraction(bufferVector, b, bufferVector);
-        if (Norm(bufferVector) < 0.00001 * Norm(b))
+        double residual = Norm(bufferVector), bNorm = Norm(b);
+        if (telemetry)
+            telemetry->NextIteration(residual / bNorm);
+        if (residual < 0.00001 * bNorm)
             break;
-        ScalarVectorProduct(tau, bufferVector, bufferVector);
-        VectorSubtraction(X, bufferVector, X);
-    }
-}
-
-int main(int argc, char **argv) {
-    N = atoi(argv[1]);
-    double tau = std::stod(argv[2]);
-    threads = atoi(argv[3]);
-
-    std::vector<double> A(N * N, 1);
-#if defined(SCHEDULE_DYNAMIC)
-#pragma omp parallel for num_threads(threads) schedule(dynamic)
-#elif defined(SCHEDULE_GUIDED)
-#pragma omp parallel for num_threads(threads) schedule(guided)
-#elif defined(SCHEDULE_AUTO)
-#pragma omp parallel for num_threads(threads) schedule(auto)
-#else
-#pragma omp parallel for num_threads(threads) schedule(static)
-#endif
+        if (M)
+            Precondition(*M, bufferVector, preconditioned);
+        ScalarVectorProduct(tau, step, step);
+        VectorSubtraction(X, step, X, Kernel::Update);
+    }
+    return iterations;
+}
+
+// Метод простой итерации сразу для нескольких правых частей: A читается один раз за итерацию для всех
+// ещё не сошедшихся столбцов. Активные столбцы X и b хранятся блоками по строкам; сошедшийся столбец
+// выписывается в X и исключается из блока, так что ширина блока со временем уменьшается.
+BlockResult BlockAlgorithm(const LinearOperator &A, const std::vector<std::vector<double>> &b,
+                           std::vector<std::vector<double>> &X, double tau) {
+    std::vector<size_t> active(b.size());
+    std::vector<double> bNorms(b.size());
+    for (size_t c = 0; c < b.size(); ++c) {
+        active[c] = c;
+        bNorms[c] = Norm(b[c]);
+    }
+    size_t width = active.size();
+    std::vector<double> blockX(N * width), blockB(N * width), nextX(N * width), residual(N * width);
+#pragma omp parallel for num_threads(threads) schedule(runtime)
     for (int i = 0; i < N; ++i)
-        A[i * N + i] = 2;
-
-    const std::vector<double> b(N, N + 1);
-    std::vector<double> X(N, 0);
-
-    const auto start{std::chrono::steady_clock::now()};
-    Algorithm(A, b, X, tau);
-    const auto end{std::chrono::steady_clock::now()};
-    const std::chrono::duration<double> elapsed_seconds{end - start};
-    std::cout << "Elapsed time: " << elapsed_seconds.count()
-              << std::endl;
-    return 0;
+        for (size_t c = 0; c < width; ++c) {
+            blockX[i * width + c] = X[c][i];
+            blockB[i * width + c] = b[c][i];
+        }
+    BlockResult result{};
+    result.columnIterations.assign(b.size(), 0);
+    while (width > 0) {
+        std::vector<double> squaredNorms(width, 0);
+        double *norms = squaredNorms.data();
+#pragma omp parallel num_threads(threads)
+        {
+            A.ApplyBlock(blockX, residual, width);
+#pragma omp for schedule(runtime) reduction(+:norms[:width])
+            for (int i = 0; i < N; ++i)
+                for (size_t c = 0; c < width; ++c) {
+                    double value = residual[i * width + c] - blockB[i * width + c];
+                    residual[i * width + c] = value;
+                    norms[c] += value * value;
+                }
+        }
+        ++result.iterations;
+        // Матрица читается один раз, векторы - для каждого активного столбца:
+        // произведение 2N, невязка 3N и обновление 3N
+        result.traffic += A.ApplyBytes() + (8.0 * width - 2) * N * sizeof(double);
+
+        std::vector<size_t> kept;
+        for (size_t c = 0; c < width; ++c) {
+            ++result.columnIterations[active[c]];
+            if (sqrt(squaredNorms[c]) >= 0.00001 * bNorms[active[c]])
+                kept.push_back(c);
+        }
+        const size_t nextWidth = kept.size();
+        if (nextWidth < width) {
+            for (size_t c = 0, next = 0; c < width; ++c) {
+                if (next < nextWidth && kept[next] == c) {
+                    ++next;
+                    continue;
+                }
+                std::vector<double> &column = X[active[c]];
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+                for (int i = 0; i < N; ++i)
+                    column[i] = blockX[i * width + c];
+            }
+            std::vector<double> nextB(N * nextWidth);
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+            for (int i = 0; i < N; ++i)
+                for (size_t c = 0; c < nextWidth; ++c)
+                    nextB[i * nextWidth + c] = blockB[i * width + kept[c]];
+            blockB.swap(nextB);
+            for (size_t c = 0; c < nextWidth; ++c)
+                active[c] = active[kept[c]];
+            active.resize(nextWidth);
+        }
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int i = 0; i < N; ++i)
+            for (size_t c = 0; c < nextWidth; ++c)
+                nextX[i * nextWidth + c] = blockX[i * width + kept[c]] - tau * residual[i * width + kept[c]];
+        blockX.swap(nextX);
+        width = nextWidth;
+    }
+    return result;
+}
+
+size_t FusedMatrixFreeAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                double tau) {
+    std::vector<double> nextX(N), product(N);
+    const double bNorm = Norm(b);
+    size_t iterations{};
+    while (true) {
+        double squaredResidual{};
+#pragma omp parallel num_threads(threads)
+        {
+            A.Apply(X, product);
+#pragma omp for schedule(runtime) reduction(+:squaredResidual)
+            for (int i = 0; i < N; ++i) {
+                double residual = product[i] - b[i];
+                squaredResidual += residual * residual;
+                nextX[i] = X[i] - tau * residual;
+            }
+        }
+        ++iterations;
+        if (sqrt(squaredResidual) < 0.00001 * bNorm)
+            break;
+        X.swap(nextX);
+    }
+    return iterations;
+}
+
+// Итерационное уточнение смешанной точности: внешний цикл в double считает истинную невязку r = b - AX
+// и прибавляет к X поправку d, а уравнение Ad = r решается методом простой итерации по копии A в float,
+// которая читается вдвое быстрее. Внутренние итерации останавливаются, когда невязка поправки уменьшилась
+// в 1 / innerTolerance раз или стала вдвое меньше требуемой невязки системы, чтобы последний шаг
+// не решался точнее нужного; критерий остановки внешнего цикла тот же, что у Algorithm.
+Refinement MixedPrecisionRefinement(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                    double tau) {
+    const double innerTolerance = 0.001;
+    std::unique_ptr<SinglePrecisionOperator> singleA = A.ToSinglePrecision();
+    std::vector<double> residual(N);
+    std::vector<float> r(N), d(N), product(N);
+    const double bNorm = Norm(b);
+    Refinement refinement{};
+    while (true) {
+        MatrixVectorProduct(A, X, residual);
+        ++refinement.outerIterations;
+        VectorSubtraction(b, residual, residual);
+        const double rNorm = Norm(residual);
+        if (rNorm < 0.00001 * bNorm)
+            break;
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int i = 0; i < N; ++i) {
+            r[i] = static_cast<float>(residual[i]);
+            d[i] = 0;
+        }
+        while (true) {
+            double squaredResidual{};
+#pragma omp parallel num_threads(threads)
+            {
+                singleA->Apply(d, product);
+#pragma omp for schedule(runtime) reduction(+:squaredResidual)
+                for (int i = 0; i < N; ++i) {
+                    float innerResidual = product[i] - r[i];
+                    squaredResidual += static_cast<double>(innerResidual) * innerResidual;
+                    d[i] -= static_cast<float>(tau) * innerResidual;
+                }
+            }
+            ++refinement.innerIterations;
+            if (sqrt(squaredResidual) < std::max(innerTolerance * rNorm, 0.5 * 0.00001 * bNorm))
+                break;
+        }
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int i = 0; i < N; ++i)
+            X[i] += d[i];
+    }
+    // Внешняя итерация: произведение, вычитание 3N, норма N, перевод r в float и обнуление d,
+    // прибавление поправки к X; внутренняя: произведение и чтение product, r, d и запись d
+    refinement.traffic = refinement.outerIterations * (A.ApplyBytes() + 7.0 * N * sizeof(double) +
+                                                       3.0 * N * sizeof(float)) +
+                         refinement.innerIterations * (singleA->ApplyBytes() + 4.0 * N * sizeof(float));
+    return refinement;
+}
+
+// Невязка, её квадрат нормы и новое приближение считаются за один проход по A;
+// новое приближение пишется в отдельный вектор, так как строкам нужен весь старый X.
+// Если строки A недоступны (матрица задана только произведением), произведение и обновление
+// выполняются двумя проходами внутри одной параллельной области.
+size_t FusedAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                      double tau) {
+    if (!A.RowAccess())
+        return FusedMatrixFreeAlgorithm(A, b, X, tau);
+    std::vector<double> nextX(N);
+    const double bNorm = Norm(b);
+    size_t iterations{};
+    while (true) {
+        double squaredResidual{};
+#pragma omp parallel for num_threads(threads) schedule(runtime) reduction(+:squaredResidual)
+        for (int i = 0; i < N; ++i) {
+            double residual = A.RowDot(i, X) - b[i];
+            squaredResidual += residual * residual;
+            nextX[i] = X[i] - tau * residual;
+        }
+        ++iterations;
+        if (sqrt(squaredResidual) < 0.00001 * bNorm)
+            break;
+        X.swap(nextX);
+    }
+    return iterations;
+}
+
+// Решение системы size x size (матрица по строкам) методом Гаусса с выбором главного элемента.
+// Возвращает false, если матрица вырождена с точностью до tolerance относительно наибольшего элемента.
+bool SolveSmallSystem(std::vector<double> matrix, std::vector<double> &rhs, size_t size, double tolerance) {
+    double scale{};
+    for (double value: matrix)
+        scale = std::max(scale, std::abs(value));
+    for (size_t k = 0; k < size; ++k) {
+        size_t pivot = k;
+        for (size_t i = k + 1; i < size; ++i)
+            if (std::abs(matrix[i * size + k]) > std::abs(matrix[pivot * size + k]))
+                pivot = i;
+        if (std::abs(matrix[pivot * size + k]) <= tolerance * scale)
+            return false;
+        if (pivot != k) {
+            std::swap_ranges(&matrix[k * size], &matrix[k * size] + size, &matrix[pivot * size]);
+            std::swap(rhs[k], rhs[pivot]);
+        }
+        for (size_t i = k + 1; i < size; ++i) {
+            double factor = matrix[i * size + k] / matrix[k * size + k];
+            for (size_t j = k; j < size; ++j)
+                matrix[i * size + j] -= factor * matrix[k * size + j];
+            rhs[i] -= factor * rhs[k];
+        }
+    }
+    for (size_t i = size; i-- > 0;) {
+        for (size_t j = i + 1; j < size; ++j)
+            rhs[i] -= matrix[i * size + j] * rhs[j];
+        rhs[i] /= matrix[i * size + i];
+    }
+    return true;
+}
+
+// Ускорение Андерсона для неподвижной точки g(X) = X - τ(AX - b) с окном depth:
+// X = g(X) - ΔG γ, где γ минимизирует ||f - ΔF γ||, f = g(X) - X, а столбцы ΔF и ΔG - разности
+// последних depth значений f и g. Разности, матрица Грама ΔF^T ΔF и ΔF^T f считаются одним проходом
+// сразу после произведения A на X, маленькая система решается одним потоком. При depth = 0 это
+// обычный метод простой итерации. history, если задан, получает ||AX - b|| / ||b|| каждой итерации.
+size_t AndersonAcceleration(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                            double tau, size_t depth, std::vector<double> *history) {
+    std::vector<double> product(N), f(N), g(N);
+    std::vector<std::vector<double>> deltaF(depth, std::vector<double>(N)), deltaG(depth, std::vector<double>(N));
+    const double bNorm = Norm(b);
+    size_t count{}, slot{}, iterations{};
+    while (true) {
+        // Со второй итерации в слот slot пишется новая пара разностей, size - число столбцов после этого
+        const bool update = iterations > 0 && depth > 0;
+        std::vector<double> &newF = update ? deltaF[slot] : f;
+        std::vector<double> &newG = update ? deltaG[slot] : g;
+        const size_t size = update ? std::min(count + 1, depth) : count;
+        const size_t gramSize = size * size + size;
+        std::vector<double> sums(gramSize + 1, 0);
+        double *partial = sums.data();
+#pragma omp parallel num_threads(threads)
+        {
+            A.Apply(X, product);
+#pragma omp for schedule(runtime) reduction(+:partial[:gramSize + 1])
+            for (int i = 0; i < N; ++i) {
+                double residual = product[i] - b[i];
+                double nextF = -tau * residual;
+                double nextG = X[i] + nextF;
+                if (update) {
+                    newF[i] = nextF - f[i];
+                    newG[i] = nextG - g[i];
+                }
+                f[i] = nextF;
+                g[i] = nextG;
+                partial[gramSize] += residual * residual;
+                for (size_t a = 0; a < size; ++a) {
+                    const double fa = deltaF[a][i];
+                    for (size_t c = 0; c <= a; ++c)
+                        partial[a * size + c] += fa * deltaF[c][i];
+                    partial[size * size + a] += fa * nextF;
+                }
+            }
+        }
+        ++iterations;
+        const double residualNorm = sqrt(sums[gramSize]);
+        if (history)
+            history->push_back(residualNorm / bNorm);
+        if (residualNorm < 0.00001 * bNorm)
+            break;
+        if (update) {
+            count = size;
+            slot = (slot + 1) % depth;
+        }
+        // Симметричная матрица Грама достраивается, при вырождении история сбрасывается
+        std::vector<double> gram(count * count), gamma(count);
+        for (size_t a = 0; a < count; ++a) {
+            for (size_t c = 0; c <= a; ++c)
+                gram[a * count + c] = gram[c * count + a] = sums[a * count + c];
+            gamma[a] = sums[count * count + a];
+        }
+        if (count > 0 && !SolveSmallSystem(gram, gamma, count, 1e-14)) {
+            count = 0;
+            slot = 0;
+        }
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int i = 0; i < N; ++i) {
+            double value = g[i];
+            for (size_t a = 0; a < count; ++a)
+                value -= gamma[a] * deltaG[a][i];
+            X[i] = value;
+        }
+    }
+    return iterations;
+}
+
+// Метод сопряжённых градиентов, A (и предобусловливатель M, если задан) должна быть симметричной
+// положительно определённой. Без M вектор z = M^-1 r совпадает с r и не хранится отдельно.
+size_t ConjugateGradient(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                         const Preconditioner *M) {
+    std::vector<double> r(N), z(M ? N : 0), p(N), Ap(N);
+    const std::vector<double> &preconditioned = M ? z : r;
+    const double bNorm = Norm(b);
+    MatrixVectorProduct(A, X, Ap);
+    VectorSubtraction(b, Ap, r);
+    if (M)
+        Precondition(*M, r, z);
+    p = preconditioned;
+    double rz = Dot(r, preconditioned);
+    size_t iterations{};
+    while ((M ? Norm(r) : sqrt(rz)) >= 0.00001 * bNorm) {
+        MatrixVectorProduct(A, p, Ap);
+        ++iterations;
+        double alpha = rz / Dot(p, Ap);
+        Axpy(alpha, p, X);
+        Axpy(-alpha, Ap, r);
+        if (M)
+            Precondition(*M, r, z);
+        double nextRz = Dot(r, preconditioned);
+        Xpay(preconditioned, nextRz / rz, p);
+        rz = nextRz;
+    }
+    return iterations;
+}
+
+// Стабилизированный метод бисопряжённых градиентов для несимметричных A, два произведения на итерацию.
+// Предобусловливатель применяется справа: A умножается на M^-1 p и M^-1 s.
+size_t BiCGSTAB(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                const Preconditioner *M) {
+    std::vector<double> r(N), rHat(N), p(N, 0), v(N, 0), s(N), t(N), pHat(M ? N : 0), sHat(M ? N : 0);
+    const std::vector<double> &preconditionedP = M ? pHat : p;
+    const std::vector<double> &preconditionedS = M ? sHat : s;
+    const double bNorm = Norm(b);
+    MatrixVectorProduct(A, X, t);
+    VectorSubtraction(b, t, r);
+    rHat = r;
+    double rho = 1, alpha = 1, omega = 1;
+    size_t iterations{};
+    while (Norm(r) >= 0.00001 * bNorm) {
+        double nextRho = Dot(rHat, r);
+        double beta = (nextRho / rho) * (alpha / omega);
+        Axpy(-omega, v, p);
+        Xpay(r, beta, p);
+        if (M)
+            Precondition(*M, p, pHat);
+        MatrixVectorProduct(A, preconditionedP, v);
+        alpha = nextRho / Dot(rHat, v);
+        s = r;
+        Axpy(-alpha, v, s);
+        Axpy(alpha, preconditionedP, X);
+        ++iterations;
+        if (Norm(s) < 0.00001 * bNorm)
+            break;
+        if (M)
+            Precondition(*M, s, sHat);
+        MatrixVectorProduct(A, preconditionedS, t);
+        omega = Dot(t, s) / Dot(t, t);
+        Axpy(omega, preconditionedS, X);
+        r = s;
+        Axpy(-omega, t, r);
+        rho = nextRho;
+    }
+    return iterations;
+}
+
+// Количество собственных значений симметричной трёхдиагональной матрицы, меньших x (последовательность Штурма)
+size_t EigenvaluesBelow(const std::vector<double> &diagonal, const std::vector<double> &offDiagonal, double x) {
+    size_t count{};
+    double d = 1;
+    for (size_t i = 0; i < diagonal.size(); ++i) {
+        double off = i == 0 ? 0 : offDiagonal[i - 1];
+        d = diagonal[i] - x - (i == 0 ? 0 : off * off / d);
+        if (d == 0)
+            d = 1e-300;
+        if (d < 0)
+            ++count;
+    }
+    return count;
+}
+
+// k-е по возрастанию собственное значение трёхдиагональной матрицы методом бисекции
+double TridiagonalEigenvalue(const std::vector<double> &diagonal, const std::vector<double> &offDiagonal, size_t k) {
+    double low = diagonal[0], high = diagonal[0];
+    for (size_t i = 0; i < diagonal.size(); ++i) {
+        double radius = (i > 0 ? std::abs(offDiagonal[i - 1]) : 0) +
+                        (i + 1 < diagonal.size() ? std::abs(offDiagonal[i]) : 0);
+        low = std::min(low, diagonal[i] - radius);
+        high = std::max(high, diagonal[i] + radius);
+    }
+    for (int step = 0; step < 100 && high - low > 1e-12 * std::max(std::abs(low), std::abs(high)); ++step) {
+        double middle = 0.5 * (low + high);
+        if (EigenvaluesBelow(diagonal, offDiagonal, middle) > k)
+            high = middle;
+        else
+            low = middle;
+    }
+    return 0.5 * (low + high);
+}
+
+// Оценка крайних собственных значений симметричной A несколькими шагами метода Ланцоша
+// со случайным начальным вектором; собственные значения трёхдиагональной матрицы Ланцоша лежат внутри спектра A,
+// поэтому интервал расширяется на spectrumMargin
+Spectrum EstimateSpectrum(const LinearOperator &A, size_t steps) {
+    const double spectrumMargin = 0.05;
+    std::vector<double> q(N), previousQ(N, 0), w(N);
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(0.5, 1.5);
+    for (size_t i = 0; i < N; ++i)
+        q[i] = distribution(generator);
+    ScalarVectorProduct(1 / Norm(q), q, q);
+    std::vector<double> alphas, betas;
+    double beta{};
+    for (size_t j = 0; j < steps && j < N; ++j) {
+        MatrixVectorProduct(A, q, w);
+        double alpha = Dot(q, w);
+        alphas.push_back(alpha);
+        Axpy(-alpha, q, w);
+        Axpy(-beta, previousQ, w);
+        beta = Norm(w);
+        if (beta <= 1e-10 * std::abs(alpha))
+            break;
+        betas.push_back(beta);
+        previousQ.swap(q);
+        ScalarVectorProduct(1 / beta, w, q);
+    }
+    Spectrum spectrum{TridiagonalEigenvalue(alphas, betas, 0), TridiagonalEigenvalue(alphas, betas, alphas.size() - 1)};
+    spectrum.min *= 1 - spectrumMargin;
+    spectrum.max *= 1 + spectrumMargin;
+    return spectrum;
+}
+
+// Шаг метода простой итерации, минимизирующий max |1 - τλ| по спектру
+double OptimalTau(const Spectrum &spectrum) {
+    return 2 / (spectrum.min + spectrum.max);
+}
+
+// Матрица D^-1/2 A D^-1/2 (D - диагональ A): её спектр совпадает со спектром D^-1 A,
+// но для симметричной A она симметрична, поэтому спектр можно оценить методом Ланцоша
+class JacobiScaledOperator final : public LinearOperator {
+public:
+    explicit JacobiScaledOperator(const LinearOperator &A) : A(A), scale(A.Size()), scaled(A.Size()) {
+        for (size_t i = 0; i < scale.size(); ++i)
+            scale[i] = 1 / sqrt(A.Diagonal(i));
+    }
+
+    size_t Size() const override {
+        return scale.size();
+    }
+
+    double Diagonal(size_t) const override {
+        return 1;
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        const int rows = static_cast<int>(scale.size());
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            scaled[i] = scale[i] * x[i];
+        A.Apply(scaled, y);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            y[i] *= scale[i];
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        const int rows = static_cast<int>(scale.size());
+        std::vector<double> &block = scaledBlock;
+#pragma omp single
+        block.resize(x.size());
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            for (size_t c = 0; c < k; ++c)
+                block[i * k + c] = scale[i] * x[i * k + c];
+        A.ApplyBlock(block, y, k);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            for (size_t c = 0; c < k; ++c)
+                y[i * k + c] *= scale[i];
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        A.RowBlock(i, first, last, out);
+        for (size_t j = first; j < last; ++j)
+            out[j - first] *= scale[i] * scale[j];
+    }
+
+    double ApplyBytes() const override {
+        return A.ApplyBytes() + 4.0 * scale.size() * sizeof(double);
+    }
+
+private:
+    const LinearOperator &A;
+    std::vector<double> scale;
+    mutable std::vector<double> scaled;
+    mutable std::vector<double> scaledBlock;
+};
+
+// Параметр SOR по формуле Юнга ω = 2 / (1 + sqrt(1 - ρ^2)), где ρ - спектральный радиус метода Якоби
+// I - D^-1 A. Формула точна для согласованно упорядоченных матриц (например, с двухцветной раскраской),
+// у них спектр I - D^-1 A симметричен относительно нуля, поэтому ρ = 1 - λmin(D^-1 A).
+// Оценка λmin занижена на 5%, так что ω получается с небольшим запасом вверх, что для SOR безопаснее.
+double OptimalOmega(const LinearOperator &A, size_t steps) {
+    Spectrum spectrum = EstimateSpectrum(JacobiScaledOperator(A), steps);
+    double rho = 1 - spectrum.min;
+    if (rho <= 0 || rho >= 1)
+        return 1;
+    return 2 / (1 + sqrt(1 - rho * rho));
+}
+
+// Чебышёвское ускорение метода простой итерации для спектра A в [spectrum.min, spectrum.max];
+// число итераций растёт как корень из числа обусловленности, а не линейно
+size_t ChebyshevIteration(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                          const Spectrum &spectrum) {
+    std::vector<double> r(N), p(N), Ap(N);
+    const double bNorm = Norm(b);
+    const double center = (spectrum.max + spectrum.min) / 2;
+    const double halfWidth = (spectrum.max - spectrum.min) / 2;
+    MatrixVectorProduct(A, X, Ap);
+    VectorSubtraction(b, Ap, r);
+    double alpha{};
+    size_t iterations{};
+    while (Norm(r) >= 0.00001 * bNorm) {
+        if (iterations == 0) {
+            p = r;
+            alpha = 1 / center;
+        } else {
+            double beta = iterations == 1 ? 0.5 * (halfWidth * alpha) * (halfWidth * alpha)
+                                          : (halfWidth * alpha / 2) * (halfWidth * alpha / 2);
+            alpha = 1 / (center - beta / alpha);
+            Xpay(r, beta, p);
+        }
+        MatrixVectorProduct(A, p, Ap);
+        ++iterations;
+        Axpy(alpha, p, X);
+        Axpy(-alpha, Ap, r);
+    }
+    return iterations;
+}
+
+// Оценка объёма данных, читаемых и записываемых за итерацию, в предположении, что X и b не помещаются в кэш
+double TrafficPerIteration(const LinearOperator &A, const std::string &method, size_t andersonDepth) {
+    double product = A.ApplyBytes();
+    double elements;
+    if (method == "fused")
+        elements = A.RowAccess() ? 2.0 * N : 5.0 * N; // b, X[i], запись nextX (и запись/чтение произведения)
+    else if (method == "sor")
+        elements = 2.0 * N; // b и запись X, чтение X учтено в произведении
+    else if (method == "anderson")
+        // проход после произведения: b, X, f и g, запись разностей и чтение окна ΔF; обновление: g, окно ΔG, X
+        elements = 10.0 * N + 2.0 * andersonDepth * N;
+    else if (method == "cg" || method == "chebyshev")
+        elements = 14.0 * N; // два скалярных произведения 4N + два axpy 6N + обновление p 3N + чтение p N
+    else if (method == "bicgstab") {
+        product *= 2.0; // два произведения на итерацию и около десятка векторных операций
+        elements = 34.0 * N;
+    } else
+        elements = 10.0 * N; // вычитание 3N + две нормы 2N + умножение 2N + вычитание 3N
+    return product + elements * sizeof(double);
 }
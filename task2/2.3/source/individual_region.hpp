@@ -0,0 +1,70 @@
+#ifndef INDIVIDUAL_REGION_HPP
+#define INDIVIDUAL_REGION_HPP
+
+#include <vector>
+#include <string>
+
+#include "linear_operator.hpp"
+#include "preconditioner.hpp"
+
+// Размерность системы и количество потоков, задаются в main
+extern size_t N;
+extern size_t threads;
+
+struct Spectrum {
+    double min;
+    double max;
+};
+
+struct Refinement {
+    size_t outerIterations;
+    size_t innerIterations;
+    double traffic; // байт за всё решение
+};
+
+struct BlockResult {
+    size_t iterations; // итераций блока, то есть чтений A
+    std::vector<size_t> columnIterations;
+    double traffic; // байт за всё решение
+};
+
+// Решатели, в которых каждая операция над векторами - отдельная параллельная область
+// с расписанием schedule(runtime). Возвращают количество итераций.
+// Предобусловливатель M необязателен: nullptr - без предобусловливания
+size_t Algorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X, double tau,
+                 const Preconditioner *M = nullptr);
+
+// Метод простой итерации для нескольких правых частей b[c], X[c] - начальные приближения и ответы
+BlockResult BlockAlgorithm(const LinearOperator &A, const std::vector<std::vector<double>> &b,
+                           std::vector<std::vector<double>> &X, double tau);
+
+size_t FusedAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X, double tau);
+
+// Итерационное уточнение с внутренними итерациями в float, A должна поддерживать ToSinglePrecision
+Refinement MixedPrecisionRefinement(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                    double tau);
+
+// Ускорение Андерсона с окном depth (0 - без ускорения); history, если не nullptr,
+// получает относительную невязку каждой итерации
+size_t AndersonAcceleration(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                            double tau, size_t depth, std::vector<double> *history = nullptr);
+
+size_t ConjugateGradient(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                         const Preconditioner *M = nullptr);
+
+size_t BiCGSTAB(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                const Preconditioner *M = nullptr);
+
+size_t ChebyshevIteration(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                          const Spectrum &spectrum);
+
+Spectrum EstimateSpectrum(const LinearOperator &A, size_t steps);
+
+double OptimalTau(const Spectrum &spectrum);
+
+// Оценка оптимального параметра SOR по steps шагам метода Ланцоша для D^-1/2 A D^-1/2
+double OptimalOmega(const LinearOperator &A, size_t steps);
+
+double TrafficPerIteration(const LinearOperator &A, const std::string &method, size_t andersonDepth = 0);
+
+#endif
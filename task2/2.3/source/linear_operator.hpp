@@ -0,0 +1,674 @@
+#ifndef LINEAR_OPERATOR_HPP
+#define LINEAR_OPERATOR_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+// result[c] = сумма row[j] * x[j * k + c] по j из [first, last] (для CSR - по элементам строки с номерами
+// столбцов columns). Столбцы блока обрабатываются группами по четыре, суммы группы держатся в регистрах,
+// поэтому каждый прочитанный элемент строки используется четыре раза.
+template<bool Indexed>
+void RowTimesBlock(const double *row, const int *columns, size_t first, size_t last, const double *x, size_t k,
+                   double *result) {
+    size_t c = 0;
+    for (; c + 4 <= k; c += 4) {
+        double sum0{}, sum1{}, sum2{}, sum3{};
+        for (size_t j = first; j < last; ++j) {
+            const double a = row[j];
+            const double *column = &x[(Indexed ? columns[j] : j) * k + c];
+            sum0 += a * column[0];
+            sum1 += a * column[1];
+            sum2 += a * column[2];
+            sum3 += a * column[3];
+        }
+        result[c] = sum0;
+        result[c + 1] = sum1;
+        result[c + 2] = sum2;
+        result[c + 3] = sum3;
+    }
+    for (; c < k; ++c) {
+        double sum{};
+        for (size_t j = first; j < last; ++j)
+            sum += row[j] * x[(Indexed ? columns[j] : j) * k + c];
+        result[c] = sum;
+    }
+}
+
+// Копия матрицы в одинарной точности для внутренних итераций смешанной точности.
+// Apply - коллективная операция, как и у LinearOperator; строки суммируются в double.
+class SinglePrecisionOperator {
+public:
+    virtual ~SinglePrecisionOperator() = default;
+
+    virtual void Apply(const std::vector<float> &x, std::vector<float> &y) const = 0;
+
+    virtual double ApplyBytes() const = 0;
+};
+
+// Матрица системы, заданная через произведение на вектор.
+// Apply - коллективная операция: её вызывают все потоки текущей параллельной области, строки распределяются
+// конструкцией omp for; вне параллельной области произведение считается одним потоком.
+class LinearOperator {
+public:
+    virtual ~LinearOperator() = default;
+
+    virtual size_t Size() const = 0;
+
+    virtual double Diagonal(size_t i) const = 0;
+
+    virtual void Apply(const std::vector<double> &x, std::vector<double> &y) const = 0;
+
+    // Произведение A на k векторов сразу, за одно чтение A. Блоки хранятся по строкам:
+    // элемент i вектора c лежит в x[i * k + c]. Коллективная операция, как и Apply.
+    virtual void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const = 0;
+
+    // Элементы строки i в столбцах [first, last), записываются в out; нужны блочным предобусловливателям
+    virtual void RowBlock(size_t i, size_t first, size_t last, double *out) const = 0;
+
+    // Количество байт, читаемых и записываемых одним вызовом Apply
+    virtual double ApplyBytes() const = 0;
+
+    // Матрица, хранящая строки явно, умеет умножать отдельную строку на вектор
+    virtual bool RowAccess() const {
+        return false;
+    }
+
+    virtual double RowDot(size_t, const std::vector<double> &) const {
+        return 0;
+    }
+
+    // Номера столбцов, в которых строка i может иметь ненулевые элементы; по умолчанию - все
+    virtual void RowPattern(size_t, std::vector<int> &columns) const {
+        columns.resize(Size());
+        for (size_t j = 0; j < columns.size(); ++j)
+            columns[j] = static_cast<int>(j);
+    }
+
+    // Копия в float; nullptr, если матрица не хранится явно и уменьшать нечего
+    virtual std::unique_ptr<SinglePrecisionOperator> ToSinglePrecision() const {
+        return nullptr;
+    }
+};
+
+class DenseSingleOperator final : public SinglePrecisionOperator {
+public:
+    DenseSingleOperator(size_t n, const std::vector<double> &matrix) : n(n), matrix(matrix.begin(), matrix.end()) {}
+
+    void Apply(const std::vector<float> &x, std::vector<float> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i) {
+            const float *row = &matrix[i * n];
+            double sum{};
+            for (size_t j = 0; j < n; ++j)
+                sum += row[j] * x[j];
+            y[i] = static_cast<float>(sum);
+        }
+    }
+
+    double ApplyBytes() const override {
+        return (static_cast<double>(n) * n + 2.0 * n) * sizeof(float);
+    }
+
+private:
+    size_t n;
+    std::vector<float> matrix;
+};
+
+class DenseOperator final : public LinearOperator {
+public:
+    explicit DenseOperator(size_t n) : n(n), matrix(n * n) {}
+
+    DenseOperator(size_t n, std::vector<double> matrix) : n(n), matrix(std::move(matrix)) {}
+
+    size_t Size() const override {
+        return n;
+    }
+
+    double Diagonal(size_t i) const override {
+        return matrix[i * n + i];
+    }
+
+    double &operator()(size_t i, size_t j) {
+        return matrix[i * n + j];
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            y[i] = RowDot(i, x);
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            RowTimesBlock<false>(&matrix[i * n], nullptr, 0, n, x.data(), k, &y[i * k]);
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        std::copy(&matrix[i * n + first], &matrix[i * n + last], out);
+    }
+
+    double ApplyBytes() const override {
+        return (static_cast<double>(n) * n + 2.0 * n) * sizeof(double);
+    }
+
+    bool RowAccess() const override {
+        return true;
+    }
+
+    double RowDot(size_t i, const std::vector<double> &x) const override {
+        const double *row = &matrix[i * n];
+        double sum{};
+        for (size_t j = 0; j < n; ++j)
+            sum += row[j] * x[j];
+        return sum;
+    }
+
+    std::unique_ptr<SinglePrecisionOperator> ToSinglePrecision() const override {
+        return std::unique_ptr<SinglePrecisionOperator>(new DenseSingleOperator(n, matrix));
+    }
+
+private:
+    size_t n;
+    std::vector<double> matrix;
+};
+
+class CsrSingleOperator final : public SinglePrecisionOperator {
+public:
+    CsrSingleOperator(size_t n, const std::vector<size_t> &rowStart, const std::vector<int> &columns,
+                      const std::vector<double> &values) :
+            n(n),
+            rowStart(rowStart),
+            columns(columns),
+            values(values.begin(), values.end()) {}
+
+    void Apply(const std::vector<float> &x, std::vector<float> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i) {
+            double sum{};
+            for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+                sum += values[k] * x[columns[k]];
+            y[i] = static_cast<float>(sum);
+        }
+    }
+
+    double ApplyBytes() const override {
+        return static_cast<double>(values.size()) * (sizeof(float) * 2 + sizeof(int)) +
+               static_cast<double>(n) * (sizeof(size_t) + sizeof(float));
+    }
+
+private:
+    size_t n;
+    std::vector<size_t> rowStart;
+    std::vector<int> columns;
+    std::vector<float> values;
+};
+
+// Разреженная матрица в формате CSR
+class CsrOperator final : public LinearOperator {
+public:
+    CsrOperator(size_t n, std::vector<size_t> rowStart, std::vector<int> columns, std::vector<double> values) :
+            n(n),
+            rowStart(std::move(rowStart)),
+            columns(std::move(columns)),
+            values(std::move(values)) {}
+
+    size_t Size() const override {
+        return n;
+    }
+
+    double Diagonal(size_t i) const override {
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            if (columns[k] == static_cast<int>(i))
+                return values[k];
+        return 0;
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            y[i] = RowDot(i, x);
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            RowTimesBlock<true>(values.data(), columns.data(), rowStart[i], rowStart[i + 1], x.data(), k, &y[i * k]);
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        std::fill(out, out + (last - first), 0.0);
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            if (columns[k] >= static_cast<int>(first) && columns[k] < static_cast<int>(last))
+                out[columns[k] - first] = values[k];
+    }
+
+    bool RowAccess() const override {
+        return true;
+    }
+
+    double RowDot(size_t i, const std::vector<double> &x) const override {
+        double sum{};
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            sum += values[k] * x[columns[k]];
+        return sum;
+    }
+
+    void RowPattern(size_t i, std::vector<int> &pattern) const override {
+        pattern.assign(columns.begin() + rowStart[i], columns.begin() + rowStart[i + 1]);
+    }
+
+    double ApplyBytes() const override {
+        return static_cast<double>(values.size()) * (sizeof(double) * 2 + sizeof(int)) +
+               static_cast<double>(n) * (sizeof(size_t) + sizeof(double));
+    }
+
+    const std::vector<size_t> &RowStart() const {
+        return rowStart;
+    }
+
+    const std::vector<int> &Columns() const {
+        return columns;
+    }
+
+    const std::vector<double> &Values() const {
+        return values;
+    }
+
+    std::unique_ptr<SinglePrecisionOperator> ToSinglePrecision() const override {
+        return std::unique_ptr<SinglePrecisionOperator>(new CsrSingleOperator(n, rowStart, columns, values));
+    }
+
+private:
+    size_t n;
+    std::vector<size_t> rowStart;
+    std::vector<int> columns;
+    std::vector<double> values;
+};
+
+class BandedSingleOperator final : public SinglePrecisionOperator {
+public:
+    BandedSingleOperator(size_t n, size_t lower, size_t upper, const std::vector<double> &band) :
+            n(n),
+            lower(lower),
+            upper(upper),
+            band(band.begin(), band.end()) {}
+
+    void Apply(const std::vector<float> &x, std::vector<float> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i) {
+            size_t first = static_cast<size_t>(i) > lower ? i - lower : 0;
+            size_t last = i + upper < n ? i + upper : n - 1;
+            const float *row = &band[i * (lower + upper + 1) + lower - i];
+            double sum{};
+            for (size_t j = first; j <= last; ++j)
+                sum += row[j] * x[j];
+            y[i] = static_cast<float>(sum);
+        }
+    }
+
+    double ApplyBytes() const override {
+        return static_cast<double>(band.size()) * sizeof(float) + 2.0 * n * sizeof(float);
+    }
+
+private:
+    size_t n;
+    size_t lower;
+    size_t upper;
+    std::vector<float> band;
+};
+
+// Ленточная матрица: lower диагоналей под главной и upper над ней, строка i хранит элементы столбцов [i - lower, i + upper]
+class BandedOperator final : public LinearOperator {
+public:
+    BandedOperator(size_t n, size_t lower, size_t upper) :
+            n(n),
+            lower(lower),
+            upper(upper),
+            band(n * (lower + upper + 1)) {}
+
+    size_t Size() const override {
+        return n;
+    }
+
+    double Diagonal(size_t i) const override {
+        return band[i * (lower + upper + 1) + lower];
+    }
+
+    // Элемент (i, j), |i - j| должен лежать в пределах ленты
+    double &operator()(size_t i, size_t j) {
+        return band[i * (lower + upper + 1) + j + lower - i];
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            y[i] = RowDot(i, x);
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        const int rows = static_cast<int>(n);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i) {
+            size_t first = static_cast<size_t>(i) > lower ? i - lower : 0;
+            size_t last = i + upper < n ? i + upper : n - 1;
+            RowTimesBlock<false>(&band[i * (lower + upper + 1) + lower - i], nullptr, first, last + 1, x.data(), k, &y[i * k]);
+        }
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        const double *row = &band[i * (lower + upper + 1) + lower - i];
+        for (size_t j = first; j < last; ++j)
+            out[j - first] = j + lower >= i && j <= i + upper ? row[j] : 0;
+    }
+
+    double ApplyBytes() const override {
+        return static_cast<double>(band.size()) * sizeof(double) + 2.0 * n * sizeof(double);
+    }
+
+    bool RowAccess() const override {
+        return true;
+    }
+
+    double RowDot(size_t i, const std::vector<double> &x) const override {
+        size_t first = i > lower ? i - lower : 0;
+        size_t last = i + upper < n ? i + upper : n - 1;
+        const double *row = &band[i * (lower + upper + 1) + lower - i];
+        double sum{};
+        for (size_t j = first; j <= last; ++j)
+            sum += row[j] * x[j];
+        return sum;
+    }
+
+    void RowPattern(size_t i, std::vector<int> &columns) const override {
+        size_t first = i > lower ? i - lower : 0;
+        size_t last = i + upper < n ? i + upper : n - 1;
+        columns.clear();
+        for (size_t j = first; j <= last; ++j)
+            columns.push_back(static_cast<int>(j));
+    }
+
+    std::unique_ptr<SinglePrecisionOperator> ToSinglePrecision() const override {
+        return std::unique_ptr<SinglePrecisionOperator>(new BandedSingleOperator(n, lower, upper, band));
+    }
+
+private:
+    size_t n;
+    size_t lower;
+    size_t upper;
+    std::vector<double> band;
+};
+
+// Матрица alpha * (вектор из единиц) * (вектор из единиц)^T + diag(d), хранится за O(N) и умножается за O(N)
+class RankOneDiagonalOperator final : public LinearOperator {
+public:
+    RankOneDiagonalOperator(double alpha, std::vector<double> diagonal) :
+            alpha(alpha),
+            diagonal(std::move(diagonal)) {}
+
+    size_t Size() const override {
+        return diagonal.size();
+    }
+
+    double Diagonal(size_t i) const override {
+        return alpha + diagonal[i];
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        const int rows = static_cast<int>(diagonal.size());
+#pragma omp single
+        sum = 0;
+        double local{};
+#pragma omp for schedule(static) nowait
+        for (int i = 0; i < rows; ++i)
+            local += x[i];
+#pragma omp atomic
+        sum += local;
+#pragma omp barrier
+        const double shift = alpha * sum;
+#pragma omp for schedule(static)
+        for (int i = 0; i < rows; ++i)
+            y[i] = shift + diagonal[i] * x[i];
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        const int rows = static_cast<int>(diagonal.size());
+#pragma omp single
+        sums.assign(k, 0);
+        std::vector<double> local(k, 0);
+#pragma omp for schedule(static) nowait
+        for (int i = 0; i < rows; ++i)
+            for (size_t c = 0; c < k; ++c)
+                local[c] += x[i * k + c];
+#pragma omp critical
+        for (size_t c = 0; c < k; ++c)
+            sums[c] += local[c];
+#pragma omp barrier
+#pragma omp for schedule(static)
+        for (int i = 0; i < rows; ++i)
+            for (size_t c = 0; c < k; ++c)
+                y[i * k + c] = alpha * sums[c] + diagonal[i] * x[i * k + c];
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        for (size_t j = first; j < last; ++j)
+            out[j - first] = alpha + (j == i ? diagonal[i] : 0);
+    }
+
+    double ApplyBytes() const override {
+        return 4.0 * diagonal.size() * sizeof(double);
+    }
+
+private:
+    double alpha;
+    std::vector<double> diagonal;
+    mutable double sum{};
+    mutable std::vector<double> sums;
+};
+
+// Симметричная матрица в блочно-треугольном виде: хранятся только блоки (I, J) при I >= J размера
+// blockSize x blockSize, в диагональных блоках - только нижний треугольник, всего около N^2 / 2 чисел.
+// Произведение читает каждый внедиагональный блок один раз и использует его и для строк блока I,
+// и транспонированным для строк блока J. Вклады копятся в собственном векторе каждого потока,
+// поэтому блоки делятся между потоками без гонок, а затем векторы потоков суммируются.
+class SymmetricOperator final : public LinearOperator {
+public:
+    explicit SymmetricOperator(size_t n, size_t blockSize = 64) :
+            n(n),
+            blockSize(blockSize),
+            blockCount((n + blockSize - 1) / blockSize),
+            blocks(blockCount * (blockCount + 1) / 2 * blockSize * blockSize) {}
+
+    size_t Size() const override {
+        return n;
+    }
+
+    double Diagonal(size_t i) const override {
+        return blocks[Offset(i, i)];
+    }
+
+    // Элемент (i, j), он же (j, i)
+    double &operator()(size_t i, size_t j) {
+        return blocks[Offset(i, j)];
+    }
+
+    void Apply(const std::vector<double> &x, std::vector<double> &y) const override {
+        std::vector<double> &own = OwnPartial(n);
+        const int pairs = static_cast<int>(blockCount * (blockCount + 1) / 2);
+#pragma omp for schedule(runtime)
+        for (int pair = 0; pair < pairs; ++pair) {
+            size_t I, J;
+            BlockIndex(pair, I, J);
+            const double *block = &blocks[pair * blockSize * blockSize];
+            const size_t rows = Width(I), columns = Width(J);
+            const double *xI = &x[I * blockSize], *xJ = &x[J * blockSize];
+            double *yI = &own[I * blockSize], *yJ = &own[J * blockSize];
+            for (size_t r = 0; r < rows; ++r) {
+                const double *row = &block[r * blockSize];
+                const size_t last = I == J ? r : columns;
+                double sum{};
+                for (size_t c = 0; c < last; ++c) {
+                    sum += row[c] * xJ[c];
+                    yJ[c] += row[c] * xI[r];
+                }
+                yI[r] += sum + (I == J ? row[r] * xI[r] : 0);
+            }
+        }
+        SumPartials(y, n);
+    }
+
+    void ApplyBlock(const std::vector<double> &x, std::vector<double> &y, size_t k) const override {
+        std::vector<double> &own = OwnPartial(n * k);
+        const int pairs = static_cast<int>(blockCount * (blockCount + 1) / 2);
+#pragma omp for schedule(runtime)
+        for (int pair = 0; pair < pairs; ++pair) {
+            size_t I, J;
+            BlockIndex(pair, I, J);
+            const double *block = &blocks[pair * blockSize * blockSize];
+            const size_t rows = Width(I), columns = Width(J);
+            for (size_t r = 0; r < rows; ++r) {
+                const size_t i = I * blockSize + r;
+                for (size_t c = 0; c < (I == J ? r + 1 : columns); ++c) {
+                    const size_t j = J * blockSize + c;
+                    const double a = block[r * blockSize + c];
+                    for (size_t v = 0; v < k; ++v) {
+                        own[i * k + v] += a * x[j * k + v];
+                        if (i != j)
+                            own[j * k + v] += a * x[i * k + v];
+                    }
+                }
+            }
+        }
+        SumPartials(y, n * k);
+    }
+
+    void RowBlock(size_t i, size_t first, size_t last, double *out) const override {
+        for (size_t j = first; j < last; ++j)
+            out[j - first] = blocks[Offset(i, j)];
+    }
+
+    // Матрица, векторы x и y и запись и чтение векторов потоков
+    double ApplyBytes() const override {
+        return static_cast<double>(blocks.size()) * sizeof(double) +
+               (2.0 + 2.0 * std::max<size_t>(partials.size(), 1)) * n * sizeof(double);
+    }
+
+private:
+    size_t Offset(size_t i, size_t j) const {
+        if (i < j)
+            std::swap(i, j);
+        const size_t I = i / blockSize, J = j / blockSize;
+        return (I * (I + 1) / 2 + J) * blockSize * blockSize + (i % blockSize) * blockSize + j % blockSize;
+    }
+
+    size_t Width(size_t block) const {
+        return std::min(blockSize, n - block * blockSize);
+    }
+
+    // Номер блока pair = I (I + 1) / 2 + J
+    static void BlockIndex(size_t pair, size_t &I, size_t &J) {
+        I = static_cast<size_t>((std::sqrt(8.0 * pair + 1) - 1) / 2);
+        while (I * (I + 1) / 2 > pair)
+            --I;
+        while ((I + 1) * (I + 2) / 2 <= pair)
+            ++I;
+        J = pair - I * (I + 1) / 2;
+    }
+
+    // Обнулённый вектор вкладов текущего потока, коллективная операция
+    std::vector<double> &OwnPartial(size_t size) const {
+#pragma omp single
+        partials.resize(omp_get_num_threads());
+        std::vector<double> &own = partials[omp_get_thread_num()];
+        own.assign(size, 0);
+        return own;
+    }
+
+    void SumPartials(std::vector<double> &y, size_t size) const {
+        const int count = static_cast<int>(size);
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < count; ++i) {
+            double sum{};
+            for (const std::vector<double> &partial: partials)
+                sum += partial[i];
+            y[i] = sum;
+        }
+    }
+
+    size_t n;
+    size_t blockSize;
+    size_t blockCount;
+    std::vector<double> blocks;
+    mutable std::vector<std::vector<double>> partials;
+};
+
+// Тестовая матрица A = (матрица из единиц) + I размера n x n в заданном представлении:
+// dense, csr, banded, symmetric (только нижний треугольник) или rank1 (без хранения матрицы)
+inline std::unique_ptr<LinearOperator> MakeTestOperator(const std::string &kind, size_t n) {
+    if (kind == "dense") {
+        std::unique_ptr<DenseOperator> A(new DenseOperator(n, std::vector<double>(n * n, 1)));
+        for (size_t i = 0; i < n; ++i)
+            (*A)(i, i) = 2;
+        return std::unique_ptr<LinearOperator>(A.release());
+    }
+    if (kind == "csr") {
+        std::vector<size_t> rowStart(n + 1);
+        std::vector<int> columns(n * n);
+        std::vector<double> values(n * n, 1);
+        for (size_t i = 0; i < n; ++i) {
+            rowStart[i + 1] = (i + 1) * n;
+            for (size_t j = 0; j < n; ++j)
+                columns[i * n + j] = static_cast<int>(j);
+            values[i * n + i] = 2;
+        }
+        return std::unique_ptr<LinearOperator>(
+                new CsrOperator(n, std::move(rowStart), std::move(columns), std::move(values)));
+    }
+    // Разреженная трёхдиагональная матрица (4 на диагонали, 1 рядом с ней) в CSR: строки раскрашиваются в два цвета
+    if (kind == "tridiagonal") {
+        std::vector<size_t> rowStart(n + 1);
+        std::vector<int> columns;
+        std::vector<double> values;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i > 0 ? i - 1 : 0; j <= i + 1 && j < n; ++j) {
+                columns.push_back(static_cast<int>(j));
+                values.push_back(i == j ? 4 : 1);
+            }
+            rowStart[i + 1] = columns.size();
+        }
+        return std::unique_ptr<LinearOperator>(
+                new CsrOperator(n, std::move(rowStart), std::move(columns), std::move(values)));
+    }
+    if (kind == "banded") {
+        std::unique_ptr<BandedOperator> A(new BandedOperator(n, n - 1, n - 1));
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j)
+                (*A)(i, j) = i == j ? 2 : 1;
+        return std::unique_ptr<LinearOperator>(A.release());
+    }
+    if (kind == "symmetric") {
+        std::unique_ptr<SymmetricOperator> A(new SymmetricOperator(n));
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j <= i; ++j)
+                (*A)(i, j) = i == j ? 2 : 1;
+        return std::unique_ptr<LinearOperator>(A.release());
+    }
+    if (kind == "rank1")
+        return std::unique_ptr<LinearOperator>(new RankOneDiagonalOperator(1, std::vector<double>(n, 1)));
+    return nullptr;
+}
+
+#endif
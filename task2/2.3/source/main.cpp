@@ -0,0 +1,401 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <omp.h>
+
+#include "linear_operator.hpp"
+#include "individual_region.hpp"
+#include "single_region.hpp"
+#include "telemetry.hpp"
+#include "matrix_market.hpp"
+
+size_t N;
+size_t threads;
+Telemetry *telemetry;
+
+struct SolverOptions {
+    std::string method = "simple";
+    std::string format = "dense";
+    std::string region = "individual";
+    std::string tau;
+    size_t checkInterval{};
+    size_t rhs = 1;
+    std::string preconditioner = "none";
+    size_t blockSize = 64;
+    double omega = 1; // 0 - оценить автоматически
+    size_t andersonDepth = 5;
+    bool telemetry{};
+    std::shared_ptr<LinearOperator> matrix; // матрица из файла (--matrix), иначе тестовая format
+};
+
+struct SolverResult {
+    double seconds;
+    size_t iterations;
+    size_t refinements;
+    Statistics statistics;
+    bool spectrumEstimated;
+    Spectrum spectrum;
+    double tau;
+    double omega;
+    double traffic; // байт за всё решение
+    double residual; // ||b - AX|| / ||b|| после решения, для нескольких правых частей - наибольшая
+    std::vector<size_t> columnIterations;
+    double setupSeconds; // построение предобусловливателя, входит в seconds
+    std::vector<double> history; // относительная невязка по итерациям (для anderson)
+    std::unique_ptr<Telemetry> telemetry; // с --telemetry, события только самой итерации
+    std::string error; // предобусловливатель не построен, система не решалась
+};
+
+double RelativeResidual(const LinearOperator &A, const std::vector<double> &b, const std::vector<double> &X) {
+    std::vector<double> product(N);
+    A.Apply(X, product);
+    double squaredResidual{}, squaredB{};
+    for (size_t i = 0; i < N; ++i) {
+        squaredResidual += (b[i] - product[i]) * (b[i] - product[i]);
+        squaredB += b[i] * b[i];
+    }
+    return sqrt(squaredResidual / squaredB);
+}
+
+SolverResult Solve(const SolverOptions &options) {
+    SolverResult result{};
+    std::shared_ptr<LinearOperator> A = options.matrix;
+    if (!A)
+        A = MakeTestOperator(options.format, N);
+    // Первая правая часть - исходная, остальные отличаются от неё, чтобы сходиться за разное число итераций.
+    // Для матрицы из файла исходная правая часть - A * (1, ..., 1)
+    std::vector<std::vector<double>> rightSides(options.rhs, std::vector<double>(N, N + 1));
+    if (options.matrix) {
+        const std::vector<double> ones(N, 1);
+#pragma omp parallel num_threads(threads)
+        A->Apply(ones, rightSides[0]);
+        for (size_t c = 1; c < options.rhs; ++c)
+            rightSides[c] = rightSides[0];
+    }
+    for (size_t c = 1; c < options.rhs; ++c)
+        for (size_t i = 0; i < N; ++i)
+            rightSides[c][i] += static_cast<double>(c) * (i % 7);
+    std::vector<std::vector<double>> solutions(options.rhs, std::vector<double>(N, 0));
+    const std::vector<double> &b = rightSides[0];
+    std::vector<double> &X = solutions[0];
+
+    const size_t spectrumSteps = 30;
+    if (options.telemetry)
+        result.telemetry.reset(new Telemetry(static_cast<int>(threads)));
+    const auto start{std::chrono::steady_clock::now()};
+    result.tau = options.tau == "auto" ? 0 : std::stod(options.tau);
+    result.spectrumEstimated = options.tau == "auto" || options.method == "chebyshev";
+    if (result.spectrumEstimated) {
+        result.spectrum = EstimateSpectrum(*A, spectrumSteps);
+        if (options.tau == "auto")
+            result.tau = OptimalTau(result.spectrum);
+    }
+    const auto setupStart{std::chrono::steady_clock::now()};
+    const bool usesOmega = options.method == "sor" || options.preconditioner == "ssor";
+    result.omega = options.omega > 0 || !usesOmega ? options.omega : OptimalOmega(*A, spectrumSteps);
+    std::unique_ptr<Preconditioner> M = MakePreconditioner(options.preconditioner, *A, options.blockSize,
+                                                           result.omega, static_cast<int>(threads));
+    result.setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+    if (M && !(result.error = M->Error()).empty())
+        return result;
+    if (options.rhs > 1) {
+        BlockResult block = BlockAlgorithm(*A, rightSides, solutions, result.tau);
+        result.iterations = block.iterations;
+        result.columnIterations = block.columnIterations;
+        result.traffic = block.traffic;
+    } else if (options.region == "single") {
+        result.statistics = options.checkInterval > 0
+                            ? CheckedAlgorithm(*A, b, X, result.tau, options.checkInterval)
+                            : SingleRegionAlgorithm(*A, b, X, result.tau);
+        result.iterations = result.statistics.iterations;
+    } else if (options.method == "sor") {
+        result.statistics = SuccessiveOverRelaxation(*A, b, X, result.omega);
+        result.iterations = result.statistics.iterations;
+    } else if (options.method == "fused")
+        result.iterations = FusedAlgorithm(*A, b, X, result.tau);
+    else if (options.method == "mixed") {
+        Refinement refinement = MixedPrecisionRefinement(*A, b, X, result.tau);
+        result.iterations = refinement.innerIterations;
+        result.refinements = refinement.outerIterations;
+        result.traffic = refinement.traffic;
+    } else if (options.method == "anderson")
+        result.iterations = AndersonAcceleration(*A, b, X, result.tau, options.andersonDepth, &result.history);
+    else if (options.method == "cg")
+        result.iterations = ConjugateGradient(*A, b, X, M.get());
+    else if (options.method == "bicgstab")
+        result.iterations = BiCGSTAB(*A, b, X, M.get());
+    else if (options.method == "chebyshev")
+        result.iterations = ChebyshevIteration(*A, b, X, result.spectrum);
+    else {
+        telemetry = result.telemetry.get();
+        result.iterations = Algorithm(*A, b, X, result.tau, M.get());
+        telemetry = nullptr;
+    }
+    const auto end{std::chrono::steady_clock::now()};
+    const std::chrono::duration<double> elapsed_seconds{end - start};
+    result.seconds = elapsed_seconds.count();
+    if (options.method != "mixed" && options.rhs == 1)
+        result.traffic = TrafficPerIteration(*A, options.method, options.andersonDepth) * result.iterations;
+    if (M)
+        result.traffic += M->ApplyBytes() * result.iterations * (options.method == "bicgstab" ? 2 : 1);
+    for (size_t c = 0; c < options.rhs; ++c)
+        result.residual = std::max(result.residual, RelativeResidual(*A, rightSides[c], solutions[c]));
+    return result;
+}
+
+// Расписание в виде kind или kind,chunk; chunk 0 - размер порции по умолчанию
+bool SetSchedule(const std::string &text) {
+    std::string kind = text.substr(0, text.find(','));
+    int chunk = text.find(',') == std::string::npos ? 0 : std::stoi(text.substr(text.find(',') + 1));
+    if (kind == "static")
+        omp_set_schedule(omp_sched_static, chunk);
+    else if (kind == "dynamic")
+        omp_set_schedule(omp_sched_dynamic, chunk);
+    else if (kind == "guided")
+        omp_set_schedule(omp_sched_guided, chunk);
+    else if (kind == "auto")
+        omp_set_schedule(omp_sched_auto, chunk);
+    else
+        return false;
+    return true;
+}
+
+std::vector<size_t> ParseList(const std::string &text) {
+    std::vector<size_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        values.push_back(std::stoul(item));
+    return values;
+}
+
+// Перебор расписание x размер порции x количество потоков x N, результаты пишутся в CSV.
+// По умолчанию количества потоков - степени двойки до threads, а размерности - N / 4, N / 2 и N.
+void Sweep(const SolverOptions &options, const std::string &path, std::vector<size_t> threadCounts,
+           std::vector<size_t> sizes, const std::vector<size_t> &chunks) {
+    const size_t maxThreads = threads, maxN = N;
+    if (threadCounts.empty())
+        for (size_t count = 1; count <= maxThreads; count *= 2)
+            threadCounts.push_back(count);
+    if (sizes.empty())
+        sizes = {maxN / 4, maxN / 2, maxN};
+    std::ofstream output(path);
+    output << "schedule,chunk,threads,N,method,operator,region,preconditioner,iterations,seconds" << std::endl;
+    for (const std::string kind: {"static", "dynamic", "guided", "auto"})
+        for (size_t chunk: chunks) {
+            if (kind == "auto" && chunk != chunks.front())
+                continue;
+            SetSchedule(kind + "," + std::to_string(chunk));
+            for (size_t size: sizes)
+                for (size_t count: threadCounts) {
+                    N = size;
+                    threads = count;
+                    SolverResult result = Solve(options);
+                    output << kind << "," << chunk << "," << threads << "," << N << "," << options.method << ","
+                           << options.format << "," << options.region << "," << options.preconditioner << ","
+                           << result.iterations << ","
+                           << result.seconds << std::endl;
+                    std::cout << kind << "," << chunk << " threads = " << threads << " N = " << N << ": "
+                              << result.seconds << std::endl;
+                }
+        }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4)
+        return 1;
+    N = atoi(argv[1]);
+    SolverOptions options;
+    options.tau = argv[2];
+    threads = atoi(argv[3]);
+    std::string sweepPath, historyPath, telemetryPath, matrixPath, reorder = "none";
+    std::vector<size_t> sweepThreads, sweepSizes, sweepChunks{0, 1, 16, 256};
+    // Без OMP_SCHEDULE используется static, как у прежней цели static
+    if (!getenv("OMP_SCHEDULE"))
+        SetSchedule("static");
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--method")
+            options.method = value;
+        else if (option == "--operator")
+            options.format = value;
+        else if (option == "--region")
+            options.region = value;
+        else if (option == "--check-every")
+            options.checkInterval = std::stoul(value);
+        else if (option == "--rhs")
+            options.rhs = std::stoul(value);
+        else if (option == "--preconditioner")
+            options.preconditioner = value;
+        else if (option == "--block-size")
+            options.blockSize = std::stoul(value);
+        else if (option == "--omega")
+            options.omega = value == "auto" ? 0 : std::stod(value);
+        else if (option == "--anderson")
+            options.andersonDepth = std::stoul(value);
+        else if (option == "--history")
+            historyPath = value;
+        else if (option == "--matrix")
+            matrixPath = value;
+        else if (option == "--reorder")
+            reorder = value;
+        else if (option == "--telemetry")
+            telemetryPath = value;
+        else if (option == "--schedule") {
+            if (!SetSchedule(value))
+                return 1;
+        } else if (option == "--sweep")
+            sweepPath = value;
+        else if (option == "--sweep-threads")
+            sweepThreads = ParseList(value);
+        else if (option == "--sweep-sizes")
+            sweepSizes = ParseList(value);
+        else if (option == "--sweep-chunks")
+            sweepChunks = ParseList(value);
+        else
+            return 1;
+    }
+    if (reorder != "none" && (reorder != "rcm" || matrixPath.empty()))
+        return 1;
+    if (!matrixPath.empty()) {
+        if (!sweepPath.empty())
+            return 1;
+        const auto readStart{std::chrono::steady_clock::now()};
+        std::unique_ptr<CsrOperator> matrix = ReadMatrixMarket(matrixPath, static_cast<int>(threads));
+        if (!matrix) {
+            std::cout << "Cannot read Matrix Market file " << matrixPath << std::endl;
+            return 1;
+        }
+        std::cout << "Matrix: " << matrix->Size() << " rows, " << matrix->Values().size() << " nonzeros, read in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - readStart).count() << " s"
+                  << std::endl;
+        if (reorder == "rcm") {
+            const auto reorderStart{std::chrono::steady_clock::now()};
+            const size_t before = Bandwidth(*matrix, static_cast<int>(threads));
+            matrix = Permute(*matrix, ReverseCuthillMcKee(*matrix), static_cast<int>(threads));
+            std::cout << "RCM bandwidth: " << before << " -> " << Bandwidth(*matrix, static_cast<int>(threads))
+                      << ", reordered in "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - reorderStart).count()
+                      << " s" << std::endl;
+        }
+        N = matrix->Size();
+        options.format = "csr";
+        options.matrix = std::move(matrix);
+    }
+    const std::string &method = options.method;
+    if (method != "simple" && method != "fused" && method != "cg" && method != "bicgstab" && method != "chebyshev" &&
+        method != "mixed" && method != "anderson" && method != "sor")
+        return 1;
+    if (options.region != "individual" && (options.region != "single" || method != "simple"))
+        return 1;
+    if (!historyPath.empty() && method != "anderson")
+        return 1;
+    // Телеметрия записывается ядрами метода простой итерации в отдельных параллельных областях
+    options.telemetry = !telemetryPath.empty();
+    if (options.telemetry && (method != "simple" || options.region != "individual" || options.rhs > 1 ||
+                              !sweepPath.empty() || options.preconditioner == "all"))
+        return 1;
+    if (options.rhs == 0 || (options.rhs > 1 && (method != "simple" || options.region != "individual")))
+        return 1;
+    // τ = auto оценивает спектр A, а не M^-1 A, поэтому с предобусловливателем τ задаётся явно
+    const std::string &preconditioner = options.preconditioner;
+    if (preconditioner != "none" && preconditioner != "all" &&
+        !MakePreconditioner(preconditioner, *MakeTestOperator("dense", 1), 1, 1, 1))
+        return 1;
+    if (preconditioner != "none" && (options.tau == "auto" || options.region != "individual" || options.rhs > 1 ||
+                                     (method != "simple" && method != "cg" && method != "bicgstab")))
+        return 1;
+    if (options.blockSize == 0 || options.omega < 0 || options.omega >= 2)
+        return 1;
+    std::unique_ptr<LinearOperator> probe = MakeTestOperator(options.format, 1);
+    if (!probe || sweepChunks.empty() || (method == "mixed" && !probe->ToSinglePrecision()) ||
+        (method == "sor" && !probe->RowAccess()))
+        return 1;
+
+    if (!sweepPath.empty() && preconditioner != "all") {
+        Sweep(options, sweepPath, sweepThreads, sweepSizes, sweepChunks);
+        return 0;
+    }
+    if (preconditioner == "all") {
+        std::cout << "preconditioner, iterations, setup time, total time, relative residual" << std::endl;
+        for (const std::string kind: {"none", "jacobi", "block-jacobi", "ssor"}) {
+            options.preconditioner = kind;
+            SolverResult result = Solve(options);
+            if (!result.error.empty()) {
+                std::cout << kind << ", " << result.error << std::endl;
+                continue;
+            }
+            std::cout << kind << ", " << result.iterations << ", " << result.setupSeconds << ", " << result.seconds
+                      << ", " << result.residual << std::endl;
+        }
+        return 0;
+    }
+
+    SolverResult result = Solve(options);
+    if (!result.error.empty()) {
+        std::cout << result.error << std::endl;
+        return 1;
+    }
+    std::cout << "Elapsed time: " << result.seconds << std::endl;
+    if (result.statistics.diverged)
+        std::cout << "Iteration diverged, the last checked approximation is returned" << std::endl;
+    if (result.spectrumEstimated)
+        std::cout << "Spectrum estimate: [" << result.spectrum.min << ", " << result.spectrum.max << "], tau = "
+                  << result.tau << std::endl;
+    if (preconditioner != "none")
+        std::cout << "Preconditioner setup time: " << result.setupSeconds << std::endl;
+    std::cout << "Iterations: " << result.iterations << std::endl;
+    if (method == "mixed")
+        std::cout << "Refinement steps: " << result.refinements << std::endl;
+    if (options.rhs > 1) {
+        std::cout << "Iterations per right-hand side:";
+        for (size_t count: result.columnIterations)
+            std::cout << " " << count;
+        std::cout << std::endl;
+    }
+    std::cout << "Relative residual: " << result.residual << std::endl;
+    // Кривые сходимости с ускорением и без него: итерация и относительная невязка обоих запусков
+    if (!historyPath.empty()) {
+        SolverOptions plainOptions = options;
+        plainOptions.andersonDepth = 0;
+        SolverResult plain = Solve(plainOptions);
+        std::cout << "Without acceleration: " << plain.iterations << " iterations, " << plain.seconds << " s"
+                  << std::endl;
+        std::ofstream output(historyPath);
+        output << "iteration,plain,anderson" << std::endl;
+        for (size_t k = 0; k < std::max(plain.history.size(), result.history.size()); ++k) {
+            output << k + 1 << ",";
+            if (k < plain.history.size())
+                output << plain.history[k];
+            output << ",";
+            if (k < result.history.size())
+                output << result.history[k];
+            output << std::endl;
+        }
+    }
+    if (result.omega != options.omega)
+        std::cout << "Estimated omega: " << result.omega << std::endl;
+    if (options.region == "single" || method == "sor") {
+        std::cout << "Barriers: " << result.statistics.barriers << " ("
+                  << static_cast<double>(result.statistics.barriers) / result.iterations << " per iteration)"
+                  << std::endl;
+        std::cout << "Time per iteration: " << result.seconds / result.iterations << std::endl;
+    }
+    if (options.region == "individual")
+        std::cout << "Memory traffic: " << result.traffic / (1 << 20) << " MiB ("
+                  << result.traffic / result.iterations / (1 << 20) << " MiB per iteration)" << std::endl;
+    if (result.telemetry) {
+        result.telemetry->Summary(std::cout);
+        const bool json = telemetryPath.size() >= 5 && telemetryPath.substr(telemetryPath.size() - 5) == ".json";
+        if (!(json ? result.telemetry->WriteJson(telemetryPath) : result.telemetry->WriteCsv(telemetryPath)))
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,304 @@
+#ifndef MATRIX_MARKET_HPP
+#define MATRIX_MARKET_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include <utility>
+
+#include "linear_operator.hpp"
+
+// Упорядочивает столбцы внутри каждой строки CSR (повторы столбца - по значению, чтобы порядок, а с ним и сумма
+// повторов в MergeDuplicates, не зависели от порядка раскладки потоками)
+inline void SortRows(const std::vector<size_t> &rowStart, std::vector<int> &columns, std::vector<double> &values,
+                     int threads) {
+    const int rows = static_cast<int>(rowStart.size() - 1);
+#pragma omp parallel num_threads(threads)
+    {
+        std::vector<std::pair<int, double>> row;
+#pragma omp for schedule(dynamic, 256)
+        for (int i = 0; i < rows; ++i) {
+            row.clear();
+            for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+                row.emplace_back(columns[k], values[k]);
+            std::sort(row.begin(), row.end());
+            for (size_t k = 0; k < row.size(); ++k) {
+                columns[rowStart[i] + k] = row[k].first;
+                values[rowStart[i] + k] = row[k].second;
+            }
+        }
+    }
+}
+
+// Суммирует повторяющиеся элементы (i, j) упорядоченных строк CSR: сначала каждая строка сжимается на месте,
+// затем, если повторы были, строки переносятся в массивы нужного размера
+inline void MergeDuplicates(std::vector<size_t> &rowStart, std::vector<int> &columns, std::vector<double> &values,
+                            int threads) {
+    const int rows = static_cast<int>(rowStart.size() - 1);
+    std::vector<size_t> newStart(rows + 1);
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 256)
+    for (int i = 0; i < rows; ++i) {
+        size_t target = rowStart[i];
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            if (target > rowStart[i] && columns[target - 1] == columns[k])
+                values[target - 1] += values[k];
+            else {
+                columns[target] = columns[k];
+                values[target] = values[k];
+                ++target;
+            }
+        newStart[i + 1] = target - rowStart[i];
+    }
+    for (int i = 0; i < rows; ++i)
+        newStart[i + 1] += newStart[i];
+    if (newStart[rows] == rowStart[rows])
+        return;
+    std::vector<int> newColumns(newStart[rows]);
+    std::vector<double> newValues(newStart[rows]);
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (int i = 0; i < rows; ++i) {
+        const size_t length = newStart[i + 1] - newStart[i];
+        std::copy_n(&columns[rowStart[i]], length, &newColumns[newStart[i]]);
+        std::copy_n(&values[rowStart[i]], length, &newValues[newStart[i]]);
+    }
+    rowStart = std::move(newStart);
+    columns = std::move(newColumns);
+    values = std::move(newValues);
+}
+
+// Чтение квадратной матрицы в формате Matrix Market (coordinate, real/integer/pattern, general/symmetric) в CSR.
+// Файл читается целиком прямо в строку, область данных делится на threads кусков по границам строк, и каждый
+// поток разбирает свой кусок в собственные тройки (строка, столбец, значение). CSR собирается параллельной сортировкой подсчётом:
+// потоки атомарно считают элементы строк в общем массиве, префиксная сумма даёт rowStart, и каждый элемент
+// занимает место атомарным сдвигом курсора своей строки; затем строки упорядочиваются по столбцам,
+// и повторы одного элемента (i, j) суммируются.
+// Память - O(N + nnz) при любом числе потоков.
+// Для symmetric хранится только нижний треугольник, верхний восстанавливается. При ошибке возвращает nullptr.
+inline std::unique_ptr<CsrOperator> ReadMatrixMarket(const std::string &path, int threads) {
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    const std::streamoff size = input ? static_cast<std::streamoff>(input.tellg()) : -1;
+    if (size < 0)
+        return nullptr;
+    std::string text(static_cast<size_t>(size), '\0');
+    input.seekg(0);
+    if (!input.read(&text[0], size))
+        return nullptr;
+
+    std::string header = text.substr(0, text.find('\n'));
+    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+    std::istringstream words(header);
+    std::string banner, object, format, field, symmetry;
+    words >> banner >> object >> format >> field >> symmetry;
+    if (banner != "%%matrixmarket" || object != "matrix" || format != "coordinate" ||
+        (field != "real" && field != "integer" && field != "pattern") ||
+        (symmetry != "general" && symmetry != "symmetric"))
+        return nullptr;
+    const bool pattern = field == "pattern", symmetric = symmetry == "symmetric";
+
+    // Строка размеров - первая после комментариев
+    size_t position = text.find('\n');
+    while (position != std::string::npos && position + 1 < text.size() && text[position + 1] == '%')
+        position = text.find('\n', position + 1);
+    if (position == std::string::npos)
+        return nullptr;
+    const char *sizes = text.c_str() + position + 1;
+    char *next;
+    const long rows = std::strtol(sizes, &next, 10), cols = std::strtol(next, &next, 10);
+    const long entries = std::strtol(next, &next, 10);
+    if (rows <= 0 || rows != cols || entries < 0)
+        return nullptr;
+    const size_t n = rows, sizesEnd = text.find('\n', next - text.c_str());
+    const size_t dataBegin = sizesEnd == std::string::npos ? text.size() : sizesEnd + 1;
+
+    struct Triplets {
+        std::vector<int> rows;
+        std::vector<int> columns;
+        std::vector<double> values;
+        long lines{};
+        bool valid = true;
+    };
+    std::vector<Triplets> parts(threads);
+    std::vector<size_t> rowStart(n + 1);
+#pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int thread = 0; thread < threads; ++thread) {
+        Triplets &part = parts[thread];
+        // Кусок начинается с первой строки, начало которой не раньше его номинальной границы
+        auto boundary = [&](int index) {
+            if (index == 0 || index == threads)
+                return index == 0 ? dataBegin : text.size();
+            const size_t nominal = dataBegin + (text.size() - dataBegin) * index / threads;
+            const size_t lineEnd = text.find('\n', nominal - 1);
+            return lineEnd == std::string::npos ? text.size() : lineEnd + 1;
+        };
+        const char *current = text.c_str() + boundary(thread), *end = text.c_str() + boundary(thread + 1);
+        while (current < end) {
+            const char *lineEnd = std::find(current, end, '\n');
+            const char *first = current;
+            while (first < lineEnd && (*first == ' ' || *first == '\t' || *first == '\r'))
+                ++first;
+            if (first < lineEnd && *first != '%') {
+                char *after;
+                const long i = std::strtol(first, &after, 10), j = std::strtol(after, &after, 10);
+                const double value = pattern ? 1 : std::strtod(after, &after);
+                if (i < 1 || i > rows || j < 1 || j > rows || after > lineEnd || (symmetric && j > i)) {
+                    part.valid = false;
+                    break;
+                }
+                ++part.lines;
+                part.rows.push_back(static_cast<int>(i - 1));
+                part.columns.push_back(static_cast<int>(j - 1));
+                part.values.push_back(value);
+                if (symmetric && i != j) {
+                    part.rows.push_back(static_cast<int>(j - 1));
+                    part.columns.push_back(static_cast<int>(i - 1));
+                    part.values.push_back(value);
+                }
+            }
+            current = lineEnd + 1;
+        }
+        for (int row: part.rows) {
+#pragma omp atomic
+            ++rowStart[row + 1];
+        }
+    }
+    long lines{};
+    for (const Triplets &part: parts) {
+        if (!part.valid)
+            return nullptr;
+        lines += part.lines;
+    }
+    if (lines != entries)
+        return nullptr;
+
+    for (size_t i = 0; i < n; ++i)
+        rowStart[i + 1] += rowStart[i];
+    std::vector<size_t> cursor(rowStart.begin(), rowStart.end() - 1);
+    std::vector<int> columns(rowStart[n]);
+    std::vector<double> values(rowStart[n]);
+#pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int thread = 0; thread < threads; ++thread) {
+        const Triplets &part = parts[thread];
+        for (size_t k = 0; k < part.rows.size(); ++k) {
+            size_t slot;
+#pragma omp atomic capture
+            slot = cursor[part.rows[k]]++;
+            columns[slot] = part.columns[k];
+            values[slot] = part.values[k];
+        }
+    }
+    SortRows(rowStart, columns, values, threads);
+    MergeDuplicates(rowStart, columns, values, threads);
+    return std::unique_ptr<CsrOperator>(
+            new CsrOperator(n, std::move(rowStart), std::move(columns), std::move(values)));
+}
+
+// Ширина ленты: наибольшее |i - j| по ненулевым элементам
+inline size_t Bandwidth(const CsrOperator &A, int threads) {
+    const std::vector<size_t> &rowStart = A.RowStart();
+    const std::vector<int> &columns = A.Columns();
+    const int rows = static_cast<int>(A.Size());
+    int width{};
+#pragma omp parallel for num_threads(threads) schedule(static) reduction(max:width)
+    for (int i = 0; i < rows; ++i)
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            width = std::max(width, std::abs(columns[k] - i));
+    return width;
+}
+
+// Обратный порядок Катхилла-Макки по графу A + A^T: обход в ширину каждой компоненты связности из вершины
+// наименьшей степени, соседи добавляются в порядке возрастания степени, итоговый порядок обращается.
+// order[k] - прежний номер строки, которая становится k-й. Обход последовательный.
+inline std::vector<int> ReverseCuthillMcKee(const CsrOperator &A) {
+    const std::vector<size_t> &rowStart = A.RowStart();
+    const std::vector<int> &columns = A.Columns();
+    const size_t n = A.Size();
+    // Столбцы A^T - строки, в которых встречается столбец
+    std::vector<size_t> transposedStart(n + 1);
+    for (int column: columns)
+        ++transposedStart[column + 1];
+    for (size_t i = 0; i < n; ++i)
+        transposedStart[i + 1] += transposedStart[i];
+    std::vector<int> transposed(columns.size());
+    std::vector<size_t> fill(transposedStart.begin(), transposedStart.end() - 1);
+    for (size_t i = 0; i < n; ++i)
+        for (size_t k = rowStart[i]; k < rowStart[i + 1]; ++k)
+            transposed[fill[columns[k]]++] = static_cast<int>(i);
+
+    std::vector<size_t> degree(n);
+    for (size_t i = 0; i < n; ++i)
+        degree[i] = rowStart[i + 1] - rowStart[i] + transposedStart[i + 1] - transposedStart[i];
+    std::vector<int> byDegree(n);
+    for (size_t i = 0; i < n; ++i)
+        byDegree[i] = static_cast<int>(i);
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) {
+        return degree[a] < degree[b];
+    });
+
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> visited(n);
+    std::vector<int> neighbours;
+    for (int start: byDegree) {
+        if (visited[start])
+            continue;
+        visited[start] = 1;
+        order.push_back(start);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            const int vertex = order[head];
+            neighbours.clear();
+            for (size_t k = rowStart[vertex]; k < rowStart[vertex + 1]; ++k)
+                if (!visited[columns[k]]) {
+                    visited[columns[k]] = 1;
+                    neighbours.push_back(columns[k]);
+                }
+            for (size_t k = transposedStart[vertex]; k < transposedStart[vertex + 1]; ++k)
+                if (!visited[transposed[k]]) {
+                    visited[transposed[k]] = 1;
+                    neighbours.push_back(transposed[k]);
+                }
+            std::stable_sort(neighbours.begin(), neighbours.end(), [&](int a, int b) {
+                return degree[a] < degree[b];
+            });
+            order.insert(order.end(), neighbours.begin(), neighbours.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Симметричная перестановка P A P^T: строка и столбец order[k] становятся k-ми
+inline std::unique_ptr<CsrOperator> Permute(const CsrOperator &A, const std::vector<int> &order, int threads) {
+    const std::vector<size_t> &rowStart = A.RowStart();
+    const std::vector<int> &columns = A.Columns();
+    const std::vector<double> &values = A.Values();
+    const size_t n = A.Size();
+    const int rows = static_cast<int>(n);
+    std::vector<int> position(n);
+    std::vector<size_t> newStart(n + 1);
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (int k = 0; k < rows; ++k) {
+        position[order[k]] = k;
+        newStart[k + 1] = rowStart[order[k] + 1] - rowStart[order[k]];
+    }
+    for (size_t k = 0; k < n; ++k)
+        newStart[k + 1] += newStart[k];
+    std::vector<int> newColumns(columns.size());
+    std::vector<double> newValues(values.size());
+#pragma omp parallel for num_threads(threads) schedule(static)
+    for (int k = 0; k < rows; ++k)
+        for (size_t source = rowStart[order[k]], target = newStart[k]; source < rowStart[order[k] + 1];
+             ++source, ++target) {
+            newColumns[target] = position[columns[source]];
+            newValues[target] = values[source];
+        }
+    SortRows(newStart, newColumns, newValues, threads);
+    return std::unique_ptr<CsrOperator>(
+            new CsrOperator(n, std::move(newStart), std::move(newColumns), std::move(newValues)));
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef PRECONDITIONER_HPP
+#define PRECONDITIONER_HPP
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include <limits>
+
+#include "linear_operator.hpp"
+
+// Предобусловливатель M ≈ A: Apply вычисляет z = M^-1 r.
+// Apply - коллективная операция, как и LinearOperator::Apply: работа распределяется конструкцией omp for.
+class Preconditioner {
+public:
+    virtual ~Preconditioner() = default;
+
+    virtual void Apply(const std::vector<double> &r, std::vector<double> &z) const = 0;
+
+    // Количество байт, читаемых и записываемых одним вызовом Apply
+    virtual double ApplyBytes() const = 0;
+
+    // Описание ошибки построения; пустая строка - предобусловливатель готов к работе
+    virtual std::string Error() const {
+        return {};
+    }
+};
+
+class JacobiPreconditioner final : public Preconditioner {
+public:
+    JacobiPreconditioner(const LinearOperator &A, int threads) : inverseDiagonal(A.Size()) {
+        const int rows = static_cast<int>(A.Size());
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            inverseDiagonal[i] = 1 / A.Diagonal(i);
+    }
+
+    void Apply(const std::vector<double> &r, std::vector<double> &z) const override {
+        const int rows = static_cast<int>(inverseDiagonal.size());
+#pragma omp for schedule(runtime)
+        for (int i = 0; i < rows; ++i)
+            z[i] = inverseDiagonal[i] * r[i];
+    }
+
+    double ApplyBytes() const override {
+        return 3.0 * inverseDiagonal.size() * sizeof(double);
+    }
+
+private:
+    std::vector<double> inverseDiagonal;
+};
+
+// Диагональные блоки A размера blockSize x blockSize (последний может быть меньше), хранятся плотно.
+// Блоки извлекаются параллельно, каждый - тем потоком, который потом с ним работает,
+// связи между блоками отбрасываются.
+class DiagonalBlocks {
+protected:
+    DiagonalBlocks(const LinearOperator &A, size_t blockSize) :
+            n(A.Size()),
+            blockSize(blockSize),
+            blocks((n + blockSize - 1) / blockSize) {}
+
+    size_t BlockCount() const {
+        return blocks.size();
+    }
+
+    size_t First(size_t block) const {
+        return block * blockSize;
+    }
+
+    size_t Width(size_t block) const {
+        return std::min(blockSize, n - First(block));
+    }
+
+    void Extract(const LinearOperator &A, size_t block) {
+        const size_t first = First(block), width = Width(block);
+        blocks[block].assign(width * width, 0);
+        for (size_t i = 0; i < width; ++i)
+            A.RowBlock(first + i, first, first + width, &blocks[block][i * width]);
+    }
+
+    double BlockBytes() const {
+        return static_cast<double>(n) * blockSize * sizeof(double) + 2.0 * n * sizeof(double);
+    }
+
+    size_t n;
+    size_t blockSize;
+    std::vector<std::vector<double>> blocks;
+};
+
+// Блочный Якоби: диагональные блоки один раз раскладываются в LU с выбором главного элемента,
+// применение - прямой и обратный ход в каждом блоке независимо.
+// Если даже главный элемент блока пренебрежимо мал (блок вырожден), Error() сообщает номер блока
+class BlockJacobiPreconditioner final : public Preconditioner, private DiagonalBlocks {
+public:
+    BlockJacobiPreconditioner(const LinearOperator &A, size_t blockSize, int threads) :
+            DiagonalBlocks(A, blockSize),
+            pivots(BlockCount()) {
+        const int count = static_cast<int>(BlockCount());
+        std::vector<char> singular(count);
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int block = 0; block < count; ++block) {
+            Extract(A, block);
+            singular[block] = !Factorize(block);
+        }
+        const size_t block = std::find(singular.begin(), singular.end(), 1) - singular.begin();
+        if (block < singular.size())
+            error = "Block-Jacobi preconditioner: diagonal block " + std::to_string(block) + " (rows " +
+                    std::to_string(First(block)) + "-" + std::to_string(First(block) + Width(block) - 1) +
+                    ") is singular, zero pivot in its LU factorization";
+    }
+
+    void Apply(const std::vector<double> &r, std::vector<double> &z) const override {
+        const int count = static_cast<int>(BlockCount());
+#pragma omp for schedule(runtime)
+        for (int block = 0; block < count; ++block) {
+            const size_t first = First(block), width = Width(block);
+            const std::vector<double> &lu = blocks[block];
+            double *y = &z[first];
+            for (size_t i = 0; i < width; ++i)
+                y[i] = r[first + pivots[block][i]];
+            for (size_t i = 0; i < width; ++i)
+                for (size_t j = 0; j < i; ++j)
+                    y[i] -= lu[i * width + j] * y[j];
+            for (size_t i = width; i-- > 0;) {
+                for (size_t j = i + 1; j < width; ++j)
+                    y[i] -= lu[i * width + j] * y[j];
+                y[i] /= lu[i * width + i];
+            }
+        }
+    }
+
+    double ApplyBytes() const override {
+        return BlockBytes();
+    }
+
+    std::string Error() const override {
+        return error;
+    }
+
+private:
+    // false, если главный элемент не больше width ε max |a(i, j)|: блок вырожден с точностью до округления
+    bool Factorize(size_t block) {
+        const size_t width = Width(block);
+        std::vector<double> &lu = blocks[block];
+        std::vector<size_t> &order = pivots[block];
+        order.resize(width);
+        for (size_t i = 0; i < width; ++i)
+            order[i] = i;
+        double largest{};
+        for (double value: lu)
+            largest = std::max(largest, std::abs(value));
+        const double tolerance = width * std::numeric_limits<double>::epsilon() * largest;
+        for (size_t k = 0; k < width; ++k) {
+            size_t pivot = k;
+            for (size_t i = k + 1; i < width; ++i)
+                if (std::abs(lu[i * width + k]) > std::abs(lu[pivot * width + k]))
+                    pivot = i;
+            if (!(std::abs(lu[pivot * width + k]) > tolerance))
+                return false;
+            if (pivot != k) {
+                std::swap_ranges(&lu[k * width], &lu[k * width] + width, &lu[pivot * width]);
+                std::swap(order[k], order[pivot]);
+            }
+            for (size_t i = k + 1; i < width; ++i) {
+                double factor = lu[i * width + k] /= lu[k * width + k];
+                for (size_t j = k + 1; j < width; ++j)
+                    lu[i * width + j] -= factor * lu[k * width + j];
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::vector<size_t>> pivots;
+    std::string error;
+};
+
+// SSOR: M = ω / (2 - ω) (D / ω + L) (D / ω)^-1 (D / ω + U), при ω = 1 - симметричный Гаусс-Зейдель.
+// Прямой и обратный ходы последовательны по строкам, поэтому выполняются внутри диагональных блоков,
+// а блоки обрабатываются параллельно.
+class SsorPreconditioner final : public Preconditioner, private DiagonalBlocks {
+public:
+    SsorPreconditioner(const LinearOperator &A, size_t blockSize, double omega, int threads) :
+            DiagonalBlocks(A, blockSize),
+            omega(omega) {
+        const int count = static_cast<int>(BlockCount());
+#pragma omp parallel for num_threads(threads) schedule(runtime)
+        for (int block = 0; block < count; ++block)
+            Extract(A, block);
+    }
+
+    void Apply(const std::vector<double> &r, std::vector<double> &z) const override {
+        const int count = static_cast<int>(BlockCount());
+#pragma omp for schedule(runtime)
+        for (int block = 0; block < count; ++block) {
+            const size_t first = First(block), width = Width(block);
+            const std::vector<double> &a = blocks[block];
+            double *y = &z[first];
+            for (size_t i = 0; i < width; ++i) {
+                double sum = r[first + i];
+                for (size_t j = 0; j < i; ++j)
+                    sum -= a[i * width + j] * y[j];
+                y[i] = sum * omega / a[i * width + i];
+            }
+            for (size_t i = 0; i < width; ++i)
+                y[i] *= a[i * width + i] / omega;
+            for (size_t i = width; i-- > 0;) {
+                double sum = y[i];
+                for (size_t j = i + 1; j < width; ++j)
+                    sum -= a[i * width + j] * y[j];
+                y[i] = sum * omega / a[i * width + i];
+            }
+            for (size_t i = 0; i < width; ++i)
+                y[i] *= (2 - omega) / omega;
+        }
+    }
+
+    double ApplyBytes() const override {
+        return BlockBytes();
+    }
+
+private:
+    double omega;
+};
+
+// Предобусловливатель по имени: none (nullptr), jacobi, block-jacobi или ssor; строится на threads потоках
+inline std::unique_ptr<Preconditioner> MakePreconditioner(const std::string &kind, const LinearOperator &A,
+                                                          size_t blockSize, double omega, int threads) {
+    if (kind == "jacobi")
+        return std::unique_ptr<Preconditioner>(new JacobiPreconditioner(A, threads));
+    if (kind == "block-jacobi")
+        return std::unique_ptr<Preconditioner>(new BlockJacobiPreconditioner(A, blockSize, threads));
+    if (kind == "ssor")
+        return std::unique_ptr<Preconditioner>(new SsorPreconditioner(A, blockSize, omega, threads));
+    return nullptr;
+}
+
+#endif
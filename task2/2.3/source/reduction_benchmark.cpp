@@ -0,0 +1,65 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include <omp.h>
+
+#include "team_reduction.hpp"
+
+// Сумма по потокам, как в исходном цикле single_region: обнуление в single, atomic, барьер и чтение в single
+double SingleAtomicSum(double &shared, double value) {
+#pragma omp single
+    shared = 0;
+#pragma omp atomic
+    shared += value;
+#pragma omp barrier
+    double result = shared;
+#pragma omp barrier
+    return result;
+}
+
+// Время одного вызова reduction в секундах и признак того, что все потоки получили верную сумму
+template<typename Reduction>
+double Measure(int threads, size_t repetitions, Reduction reduction, bool &correct) {
+    double elapsed{};
+    bool ok = true;
+#pragma omp parallel num_threads(threads) reduction(&&:ok)
+    {
+        const int threadId = omp_get_thread_num();
+        const int nThreads = omp_get_num_threads();
+        const double expected = static_cast<double>(nThreads) * (nThreads + 1) / 2;
+#pragma omp barrier
+        const double start = omp_get_wtime();
+        for (size_t k = 0; k < repetitions; ++k)
+            ok = ok && reduction(threadId, threadId + 1.0) == expected;
+#pragma omp barrier
+#pragma omp master
+        elapsed = omp_get_wtime() - start;
+    }
+    correct = ok;
+    return elapsed / repetitions;
+}
+
+int main(int argc, char **argv) {
+    int maxThreads = argc > 1 ? atoi(argv[1]) : 128;
+    size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 10000;
+    std::cout << "threads, single+atomic (us), TeamReduction (us), speedup" << std::endl;
+    for (int threads = 2; threads <= maxThreads; threads *= 2) {
+        double shared{};
+        bool atomicCorrect, treeCorrect;
+        double atomicTime = Measure(threads, repetitions, [&shared](int, double value) {
+            return SingleAtomicSum(shared, value);
+        }, atomicCorrect);
+        TeamReduction team(threads);
+        double treeTime = Measure(threads, repetitions, [&team](int threadId, double value) {
+            return team.Sum(threadId, value);
+        }, treeCorrect);
+        if (!atomicCorrect || !treeCorrect) {
+            std::cout << "Wrong sum for " << threads << " threads" << std::endl;
+            return 1;
+        }
+        std::cout << threads << ", " << std::fixed << std::setprecision(3) << atomicTime * 1e6 << ", "
+                  << treeTime * 1e6 << ", " << std::setprecision(2) << atomicTime / treeTime << std::endl;
+    }
+    return 0;
+}
@@ -1,21 +1,11 @@
-#include <iostream>
 #include <vector>
 #include <cmath>
-#include <chrono>
 #include <omp.h>
-#include <iomanip>
+#include <limits>
+#include <algorithm>
 
-size_t N;
-size_t threads;
-
-void MatrixVectorProduct(const std::vector<double> &matrix, const std::vector<double> &vector,
-                         std::vector<double> &resultVector, int lb, int ub) {
-    for (int i = lb; i <= ub; ++i) {
-        resultVector[i] = 0;
-        for (int j = 0; j < N; ++j)
-            resultVector[i] += matrix[i * N + j] * vector[j];
-    }
-}
+#include "single_region.hpp"
+#include "team_reduction.hpp"
 
 void VectorSubtraction(const std::vector<double> &vector0, const std::vector<double> &vector1,
                        std::vector<double> &resultVector, int lb, int ub) {
@@ -36,9 +26,11 @@ double squaredNorm(const std::vector<double> &vector, int lb, int ub) {
     return result;
 }
 
-void Algorithm(const std::vector<double> &A, const std::vector<double> &b, std::vector<double> &X, double tau) {
+Statistics SingleRegionAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                 double tau) {
     std::vector<double> bufferVector(N);
-    double numerator{}, denominator{};
+    std::unique_ptr<TeamReduction> reduction;
+    Statistics statistics{};
 #pragma omp parallel num_threads(threads)
     {
         int nThreads = omp_get_num_threads();
@@ -46,51 +38,202 @@ void Algorithm(const std::vector<double> &A, const std::vector<double> &b, std::
         int items_per_thread = N / nThreads;
         int lb = threadId * items_per_thread;
         int ub = (threadId == nThreads - 1) ? (N - 1) : (lb + items_per_thread - 1);
-        double numBuf{}, denomBuf{};
+#pragma omp single
+        reduction.reset(new TeamReduction(nThreads));
+        const double denominator = sqrt(reduction->Sum(threadId, squaredNorm(b, lb, ub)));
         while (true) {
-            MatrixVectorProduct(A, X, bufferVector, lb, ub);
+            A.Apply(X, bufferVector);
             VectorSubtraction(bufferVector, b, bufferVector, lb, ub);
-            numBuf = squaredNorm(bufferVector, lb, ub);
-            denomBuf = squaredNorm(b, lb, ub);
-#pragma omp single
-            {
-                numerator = 0;
-                denominator = 0;
-            }
-#pragma omp atomic
-                numerator += numBuf;
-#pragma omp atomic
-                denominator += denomBuf;
-#pragma omp single
-            {
-                numerator = sqrt(numerator);
-                denominator = sqrt(denominator);
-            }
+            const double numerator = sqrt(reduction->Sum(threadId, squaredNorm(bufferVector, lb, ub)));
+            if (threadId == 0)
+                ++statistics.iterations;
             if (numerator < 0.00001 * denominator)
                 break;
             ScalarVectorProduct(tau, bufferVector, bufferVector, lb, ub);
             VectorSubtraction(X, bufferVector, X, lb, ub);
+#pragma omp barrier
         }
     }
+    // single и норма b до цикла; на итерации - Apply, TeamReduction и барьер перед следующим произведением
+    statistics.barriers = 2 + 3 * statistics.iterations - 1;
+    return statistics;
 }
 
-int main(int argc, char **argv) {
-    N = atoi(argv[1]);
-    double tau = std::stod(argv[2]);
-    threads = atoi(argv[3]);
-
-    std::vector<double> A(N * N, 1);
-#pragma omp parallel for num_threads(threads)
-    for (int i = 0; i < N; ++i)
-        A[i * N + i] = 2;
+// Метод простой итерации с проверкой сходимости раз в checkInterval итераций.
+// Новое приближение пишется во второй буфер, поэтому на итерацию приходится один барьер
+// (два, если у A нет доступа к строкам). На итерации с проверкой этим барьером служит TeamReduction,
+// которая одновременно собирает норму невязки и раздаёт её всем потокам.
+// Для симметричной положительно определённой A при сходящемся τ норма невязки не растёт,
+// поэтому её рост между проверками означает расходимость: приближение откатывается к последнему проверенному.
+Statistics CheckedAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X, double tau,
+                            size_t checkInterval) {
+    std::vector<double> bufferVector(N), nextX(N), snapshot(X);
+    std::unique_ptr<TeamReduction> reduction;
+    Statistics statistics{};
+#pragma omp parallel num_threads(threads)
+    {
+        int nThreads = omp_get_num_threads();
+        int threadId = omp_get_thread_num();
+        int items_per_thread = N / nThreads;
+        int lb = threadId * items_per_thread;
+        int ub = (threadId == nThreads - 1) ? (N - 1) : (lb + items_per_thread - 1);
+#pragma omp single
+        reduction.reset(new TeamReduction(nThreads));
+        const double bNorm = sqrt(reduction->Sum(threadId, squaredNorm(b, lb, ub)));
+        size_t barriers{2};
+        double previousResidual = std::numeric_limits<double>::infinity();
+        std::vector<double> *current = &X, *next = &nextX;
+        for (size_t iteration = 0;; ++iteration) {
+            const bool check = iteration % checkInterval == 0;
+            if (!A.RowAccess()) {
+                A.Apply(*current, bufferVector);
+                ++barriers;
+            }
+            double numBuf{};
+            for (int i = lb; i <= ub; ++i) {
+                double residual = (A.RowAccess() ? A.RowDot(i, *current) : bufferVector[i]) - b[i];
+                if (check)
+                    numBuf += residual * residual;
+                (*next)[i] = (*current)[i] - tau * residual;
+            }
+            ++barriers;
+            if (check) {
+                const double residual = sqrt(reduction->Sum(threadId, numBuf));
+                if (residual < 0.00001 * bNorm || !(residual < previousResidual)) {
+                    if (!(residual < previousResidual)) {
+                        for (int i = lb; i <= ub; ++i)
+                            X[i] = snapshot[i];
+                        if (threadId == 0)
+                            statistics.diverged = true;
+                    } else if (current != &X) {
+                        for (int i = lb; i <= ub; ++i)
+                            X[i] = (*current)[i];
+                    }
+                    if (threadId == 0) {
+                        statistics.iterations = iteration + 1;
+                        statistics.barriers = barriers;
+                    }
+                    break;
+                }
+                previousResidual = residual;
+                for (int i = lb; i <= ub; ++i)
+                    snapshot[i] = (*current)[i];
+            } else {
+#pragma omp barrier
+            }
+            std::swap(current, next);
+        }
+    }
+    return statistics;
+}
 
-    const std::vector<double> b(N, N + 1);
-    std::vector<double> X(N, 0);
+// Жадная раскраска строк: строки одного цвета не связаны ни в одну сторону (A(i, j) = A(j, i) = 0),
+// поэтому их можно обновлять на месте параллельно. Шаблон симметризуется, это до 2 nnz номеров строк.
+// Если в строках в среднем больше maxColors элементов (nnz > maxColors n), раскраска почти наверняка
+// не уложится в maxColors цветов, и шаблон не строится; в этом и в случае нехватки цветов
+// возвращается пустая раскраска.
+std::vector<std::vector<int>> ColorRows(const LinearOperator &A, size_t maxColors) {
+    const size_t n = A.Size();
+    const size_t budget = 2 * maxColors * n;
+    std::vector<std::vector<int>> neighbours(n);
+    std::vector<int> pattern;
+    size_t total{};
+    for (size_t i = 0; i < n; ++i) {
+        A.RowPattern(i, pattern);
+        total += 2 * pattern.size();
+        if (total > budget)
+            return {};
+        for (int j: pattern)
+            if (j != static_cast<int>(i)) {
+                neighbours[i].push_back(j);
+                neighbours[j].push_back(static_cast<int>(i));
+            }
+    }
+    std::vector<std::vector<int>> colors;
+    std::vector<int> color(n, -1);
+    std::vector<size_t> lastUse(maxColors + 1, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (int j: neighbours[i])
+            if (color[j] >= 0)
+                lastUse[color[j]] = i;
+        size_t c = 0;
+        while (c < colors.size() && lastUse[c] == i)
+            ++c;
+        if (c == maxColors)
+            return {};
+        if (c == colors.size())
+            colors.emplace_back();
+        color[i] = static_cast<int>(c);
+        colors[c].push_back(static_cast<int>(i));
+    }
+    return colors;
+}
 
-    const auto start{std::chrono::steady_clock::now()};
-    Algorithm(A, b, X, tau);
-    const auto end{std::chrono::steady_clock::now()};
-    const std::chrono::duration<double> elapsed_seconds{end - start};
-    std::cout << "Elapsed time: " << std::fixed << std::setprecision(5) << elapsed_seconds.count() << std::endl;
-    return 0;
+// Метод SOR (Гаусс-Зейдель при ω = 1), обновляющий X на месте.
+// Строки одного цвета обновляются параллельно, между цветами - барьер. Цветов допускается столько, чтобы
+// на каждый поток в среднем приходилось не меньше 64 строк цвета, но не меньше 32. Если раскраска не удалась
+// (почти плотная матрица), проход по строкам выполняет один поток, остальные ждут его на одном барьере.
+// Остановка - по норме невязок строк в момент их обновления, затем подтверждается истинной невязкой.
+Statistics SuccessiveOverRelaxation(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                    double omega) {
+    const size_t maxColors = std::max<size_t>(32, N / (64 * threads));
+    const std::vector<std::vector<int>> colors = ColorRows(A, maxColors);
+    std::unique_ptr<TeamReduction> reduction;
+    Statistics statistics{};
+#pragma omp parallel num_threads(threads)
+    {
+        int nThreads = omp_get_num_threads();
+        int threadId = omp_get_thread_num();
+        int items_per_thread = N / nThreads;
+        int lb = threadId * items_per_thread;
+        int ub = (threadId == nThreads - 1) ? (N - 1) : (lb + items_per_thread - 1);
+#pragma omp single
+        reduction.reset(new TeamReduction(nThreads));
+        const double bNorm = sqrt(reduction->Sum(threadId, squaredNorm(b, lb, ub)));
+        size_t barriers{2};
+        for (size_t sweep = 1;; ++sweep) {
+            double squaredResidual{};
+            if (!colors.empty()) {
+                for (const std::vector<int> &rows: colors) {
+                    const int count = static_cast<int>(rows.size());
+#pragma omp for schedule(runtime)
+                    for (int k = 0; k < count; ++k) {
+                        const int i = rows[k];
+                        double residual = b[i] - A.RowDot(i, X);
+                        squaredResidual += residual * residual;
+                        X[i] += omega * residual / A.Diagonal(i);
+                    }
+                }
+                barriers += colors.size();
+            } else {
+#pragma omp single
+                for (size_t i = 0; i < N; ++i) {
+                    double residual = b[i] - A.RowDot(i, X);
+                    squaredResidual += residual * residual;
+                    X[i] += omega * residual / A.Diagonal(i);
+                }
+                ++barriers;
+            }
+            double residual = sqrt(reduction->Sum(threadId, squaredResidual));
+            ++barriers;
+            if (residual < 0.00001 * bNorm) {
+                double trueResidual{};
+                for (int i = lb; i <= ub; ++i) {
+                    double value = A.RowDot(i, X) - b[i];
+                    trueResidual += value * value;
+                }
+                residual = sqrt(reduction->Sum(threadId, trueResidual));
+                ++barriers;
+            }
+            if (residual < 0.00001 * bNorm || !std::isfinite(residual)) {
+                if (threadId == 0) {
+                    statistics.iterations = sweep;
+                    statistics.barriers = barriers;
+                    statistics.diverged = !std::isfinite(residual);
+                }
+                break;
+            }
+        }
+    }
+    return statistics;
 }
@@ -0,0 +1,29 @@
+#ifndef SINGLE_REGION_HPP
+#define SINGLE_REGION_HPP
+
+#include <vector>
+
+#include "linear_operator.hpp"
+
+extern size_t N;
+extern size_t threads;
+
+// Количество барьеров, пройденных потоком 0, и итераций последнего запуска
+struct Statistics {
+    size_t iterations;
+    size_t barriers;
+    bool diverged;
+};
+
+// Метод простой итерации, целиком выполняемый в одной параллельной области
+Statistics SingleRegionAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                 double tau);
+
+Statistics CheckedAlgorithm(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X, double tau,
+                            size_t checkInterval);
+
+// SOR с параметром omega, X обновляется на месте; iterations - количество проходов по всем строкам
+Statistics SuccessiveOverRelaxation(const LinearOperator &A, const std::vector<double> &b, std::vector<double> &X,
+                                    double omega);
+
+#endif
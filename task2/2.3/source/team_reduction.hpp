@@ -0,0 +1,53 @@
+#ifndef TEAM_REDUCTION_HPP
+#define TEAM_REDUCTION_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Сумма значений всех потоков команды за один проход по бинарному дереву.
+// Каждый поток пишет в свою выровненную по кэш-линии ячейку, ждёт сумм поддеревьев своих детей
+// и публикует сумму своего поддерева; корень публикует общий итог, который читают все потоки.
+// Вызов Sum - коллективная операция и одновременно барьер: после возврата видны все записи,
+// сделанные потоками до вызова. Порядок сложения фиксирован, поэтому результат одинаков у всех потоков.
+class TeamReduction {
+public:
+    explicit TeamReduction(int threads) : threads(threads), slots(threads) {}
+
+    double Sum(int threadId, double value) {
+        Slot &own = slots[threadId];
+        const uint64_t epoch = ++own.calls;
+        for (int child = 2 * threadId + 1; child <= 2 * threadId + 2 && child < threads; ++child) {
+            Wait(slots[child].ready, epoch);
+            value += slots[child].value;
+        }
+        own.value = value;
+        own.ready.store(epoch, std::memory_order_release);
+        if (threadId == 0) {
+            total.value = value;
+            total.ready.store(epoch, std::memory_order_release);
+        }
+        Wait(total.ready, epoch);
+        return total.value;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> ready{0};
+        double value{};
+        uint64_t calls{};
+    };
+
+    static void Wait(const std::atomic<uint64_t> &flag, uint64_t epoch) {
+        for (int spin = 0; flag.load(std::memory_order_acquire) < epoch; ++spin)
+            if (spin > 64)
+                std::this_thread::yield();
+    }
+
+    int threads;
+    std::vector<Slot> slots;
+    Slot total;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <omp.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class Kernel : uint8_t {
+    Matvec,
+    Subtraction,
+    Norm,
+    Update,
+    Barrier
+};
+
+inline const char *KernelName(Kernel kernel) {
+    static const char *names[] = {"matvec", "subtraction", "norm", "update", "barrier_wait"};
+    return names[static_cast<int>(kernel)];
+}
+
+struct TelemetryEvent {
+    uint64_t start;
+    uint64_t end;
+    uint32_t iteration;
+    Kernel kernel;
+};
+
+// Телеметрия решателя: невязка на каждой итерации и интервалы работы ядер и ожидания на барьерах каждого потока.
+// Отметки времени - счётчик тактов (rdtsc, на других процессорах - steady_clock), события пишутся в кольцевой
+// буфер своего потока без синхронизации; при переполнении старые события затираются.
+class Telemetry {
+public:
+    explicit Telemetry(int threads, size_t capacity = 1 << 16) : rings(threads), capacity(capacity) {
+        for (Ring &ring: rings)
+            ring.events.resize(capacity);
+        // Калибровка тактов по steady_clock
+        const auto start{std::chrono::steady_clock::now()};
+        const uint64_t startTicks = Now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10)) {}
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        secondsPerTick = elapsed.count() / static_cast<double>(Now() - startTicks);
+        origin = Now();
+    }
+
+    static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Вызывается потоком, выполнившим участок
+    void Record(Kernel kernel, uint64_t start, uint64_t end) {
+        Ring &ring = rings[omp_get_thread_num()];
+        ring.events[ring.count % capacity] = {start, end, iteration, kernel};
+        ++ring.count;
+    }
+
+    // Вызывается вне параллельной области в конце итерации
+    void NextIteration(double relativeResidual) {
+        residuals.push_back(relativeResidual);
+        ++iteration;
+    }
+
+    // Время по ядрам для каждой пары (итерация, поток): iteration,thread,residual,matvec,...,barrier_wait
+    bool WriteCsv(const std::string &path) const {
+        std::ofstream output(path);
+        output << "iteration,thread,residual";
+        for (int kernel = 0; kernel < kernelCount; ++kernel)
+            output << "," << KernelName(static_cast<Kernel>(kernel));
+        output << std::endl;
+        std::vector<double> seconds(rings.size() * kernelCount);
+        for (uint32_t current = FirstIteration(); current < iteration; ++current) {
+            std::fill(seconds.begin(), seconds.end(), 0.0);
+            for (size_t thread = 0; thread < rings.size(); ++thread)
+                ForEach(thread, [&](const TelemetryEvent &event) {
+                    if (event.iteration == current)
+                        seconds[thread * kernelCount + static_cast<int>(event.kernel)] +=
+                                (event.end - event.start) * secondsPerTick;
+                });
+            for (size_t thread = 0; thread < rings.size(); ++thread) {
+                output << current + 1 << "," << thread << "," << residuals[current];
+                for (int kernel = 0; kernel < kernelCount; ++kernel)
+                    output << "," << seconds[thread * kernelCount + kernel];
+                output << std::endl;
+            }
+        }
+        return static_cast<bool>(output);
+    }
+
+    // Все сохранённые события с началом и длительностью в секундах от создания телеметрии
+    bool WriteJson(const std::string &path) const {
+        std::ofstream output(path);
+        output << "{\"seconds_per_tick\": " << secondsPerTick << ", \"dropped_events\": " << Dropped()
+               << ", \"residuals\": [";
+        for (size_t k = 0; k < residuals.size(); ++k)
+            output << (k ? ", " : "") << residuals[k];
+        output << "], \"events\": [";
+        bool first = true;
+        for (size_t thread = 0; thread < rings.size(); ++thread)
+            ForEach(thread, [&](const TelemetryEvent &event) {
+                output << (first ? "" : ",") << "\n  {\"iteration\": " << event.iteration + 1 << ", \"thread\": "
+                       << thread << ", \"kernel\": \"" << KernelName(event.kernel) << "\", \"start\": "
+                       << (event.start - origin) * secondsPerTick << ", \"duration\": "
+                       << (event.end - event.start) * secondsPerTick << "}";
+                first = false;
+            });
+        output << "\n]}" << std::endl;
+        return static_cast<bool>(output);
+    }
+
+    // Суммарное время ядер по всем итерациям и потокам и наибольшее и наименьшее по потокам ожидание на барьерах
+    void Summary(std::ostream &output) const {
+        std::vector<double> total(kernelCount);
+        std::vector<double> waits(rings.size());
+        for (size_t thread = 0; thread < rings.size(); ++thread)
+            ForEach(thread, [&](const TelemetryEvent &event) {
+                double seconds = (event.end - event.start) * secondsPerTick;
+                total[static_cast<int>(event.kernel)] += seconds;
+                if (event.kernel == Kernel::Barrier)
+                    waits[thread] += seconds;
+            });
+        output << "Thread-seconds per kernel:";
+        for (int kernel = 0; kernel < kernelCount; ++kernel)
+            output << " " << KernelName(static_cast<Kernel>(kernel)) << " = " << total[kernel];
+        output << std::endl << "Barrier wait per thread: min = " << *std::min_element(waits.begin(), waits.end())
+               << ", max = " << *std::max_element(waits.begin(), waits.end()) << std::endl;
+        if (Dropped() > 0)
+            output << "Ring buffers overflowed, the oldest " << Dropped() << " events were dropped" << std::endl;
+    }
+
+private:
+    static constexpr int kernelCount = 5;
+
+    struct alignas(64) Ring {
+        std::vector<TelemetryEvent> events;
+        uint64_t count{};
+    };
+
+    template<typename Function>
+    void ForEach(size_t thread, Function function) const {
+        const Ring &ring = rings[thread];
+        for (uint64_t k = ring.count > capacity ? ring.count - capacity : 0; k < ring.count; ++k)
+            function(ring.events[k % capacity]);
+    }
+
+    uint64_t Dropped() const {
+        uint64_t dropped{};
+        for (const Ring &ring: rings)
+            dropped += ring.count > capacity ? ring.count - capacity : 0;
+        return dropped;
+    }
+
+    // Первая итерация, события которой сохранились у всех потоков
+    uint32_t FirstIteration() const {
+        uint32_t first{};
+        for (const Ring &ring: rings)
+            if (ring.count > capacity)
+                first = std::max(first, ring.events[ring.count % capacity].iteration + 1);
+        return first;
+    }
+
+    std::vector<Ring> rings;
+    size_t capacity;
+    std::vector<double> residuals;
+    uint32_t iteration{};
+    double secondsPerTick;
+    uint64_t origin;
+};
+
+// Телеметрия текущего запуска; nullptr - выключена, и замеры сводятся к проверке указателя
+extern Telemetry *telemetry;
+
+// Замер работы одного потока в параллельной области: от создания до Barrier - участок kernel,
+// затем ожидание остальных потоков на барьере
+class KernelTimer {
+public:
+    explicit KernelTimer(Kernel kernel) : kernel(kernel), start(telemetry ? Telemetry::Now() : 0) {}
+
+    void Barrier() {
+        uint64_t end{};
+        if (telemetry) {
+            end = Telemetry::Now();
+            telemetry->Record(kernel, start, end);
+        }
+#pragma omp barrier
+        if (telemetry)
+            telemetry->Record(Kernel::Barrier, end, Telemetry::Now());
+    }
+
+private:
+    Kernel kernel;
+    uint64_t start;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <omp.h>
+
+#include <tbb/global_control.h>
+
+#include "thread_pool.hpp"
+#include "parallel.hpp"
+#include "execution.hpp"
+
+// Скалярное произведение строки на вектор - то же, что в ExecutionMultiplication, чтобы таблица сравнивала
+// только среды выполнения: unseq разрешает переставлять сложения и векторизовать цикл
+double RowProduct(const double *row, const double *x, int N) {
+    return std::transform_reduce(std::execution::unseq, row, row + N, x, 0.0);
+}
+
+// Диапазон строк потока thread из threads, как в task2.1: поровну, остаток - последнему
+void Bounds(int N, int thread, int threads, int &lb, int &ub) {
+    int itemsPerThread = N / threads;
+    lb = thread * itemsPerThread;
+    ub = (thread == threads - 1) ? (N - 1) : (lb + itemsPerThread - 1);
+}
+
+// Сравнение сред выполнения умножения матрицы на вектор на одних и тех же данных:
+// comparison N maxThreads [calls]. Для 1, 2, 4, ..., maxThreads потоков печатает таблицу
+// runtime, threads, time, speedup, efficiency; ускорение - относительно последовательного цикла.
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 4)
+        return 1;
+    int N = atoi(argv[1]);
+    int maxThreads = atoi(argv[2]);
+    int calls = argc == 4 ? atoi(argv[3]) : 10;
+    if (N <= 0 || maxThreads <= 0 || calls <= 0)
+        return 1;
+    std::vector<double> matrix(static_cast<size_t>(N) * N), vector(N), reference(N), resultVector(N);
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j)
+            matrix[static_cast<size_t>(i) * N + j] = i + j;
+        vector[i] = i;
+    }
+    const std::vector<int> rows = RowIndices(N);
+
+    auto measure = [&](const std::function<void()> &multiply) {
+        multiply(); // прогрев: создание потоков среды и первое обращение к памяти
+        const auto start = std::chrono::steady_clock::now();
+        for (int call = 0; call < calls; ++call)
+            multiply();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / calls;
+    };
+    const double serial = measure([&] {
+        for (int i = 0; i < N; ++i)
+            reference[i] = RowProduct(&matrix[static_cast<size_t>(i) * N], vector.data(), N);
+    });
+
+    std::cout << "runtime, threads, time (s), speedup, efficiency" << std::endl;
+    std::cout << std::fixed << std::setprecision(6) << "serial, 1, " << serial << ", 1.00, 1.00" << std::endl;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        parallel::Team team(threads);
+        // Ограничение TBB задаётся один раз на количество потоков, вне замеряемых вызовов
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+        const std::vector<std::pair<std::string, std::function<void()>>> runtimes = {
+                {"std::thread pool", [&] {
+                    pool.Run([&](int thread) {
+                        int lb, ub;
+                        Bounds(N, thread, threads, lb, ub);
+                        for (int i = lb; i <= ub; ++i)
+                            resultVector[i] = RowProduct(&matrix[static_cast<size_t>(i) * N], vector.data(), N);
+                    });
+                }},
+                {"std::jthread ParallelFor", [&] {
+                    parallel::ParallelFor(team, 0, N, [&](int lb, int ub) {
+                        for (int i = lb; i < ub; ++i)
+                            resultVector[i] = RowProduct(&matrix[static_cast<size_t>(i) * N], vector.data(), N);
+                    });
+                }},
+                {"OpenMP", [&] {
+#pragma omp parallel num_threads(threads)
+                    {
+                        int lb, ub;
+                        Bounds(N, omp_get_thread_num(), omp_get_num_threads(), lb, ub);
+                        for (int i = lb; i <= ub; ++i)
+                            resultVector[i] = RowProduct(&matrix[static_cast<size_t>(i) * N], vector.data(), N);
+                    }
+                }},
+                {"std::execution par_unseq", [&] {
+                    ExecutionMultiplication(N, rows, matrix, vector, resultVector);
+                }}};
+        for (const auto &[name, multiply]: runtimes) {
+            std::fill(resultVector.begin(), resultVector.end(), 0.0);
+            const double time = measure(multiply);
+            for (int i = 0; i < N; ++i)
+                if (std::abs(resultVector[i] - reference[i]) > 1e-9 * std::abs(reference[i])) {
+                    std::cout << name << " computed a wrong result" << std::endl;
+                    return 1;
+                }
+            std::cout << name << ", " << threads << ", " << time << ", " << std::setprecision(2) << serial / time
+                      << ", " << serial / time / threads << std::setprecision(6) << std::endl;
+        }
+    }
+
+    return 0;
+}
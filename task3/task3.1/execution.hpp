@@ -0,0 +1,28 @@
+#ifndef EXECUTION_HPP
+#define EXECUTION_HPP
+
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <execution>
+
+// Номера строк 0, ..., N - 1. Параллельным алгоритмам нужны итераторы произвольного доступа: у std::views::iota
+// категория input_iterator_tag, и TBB выполняет такой цикл на одном потоке
+inline std::vector<int> RowIndices(int N) {
+    std::vector<int> rows(N);
+    std::iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
+
+// Умножение матрицы N x N (по строкам) на вектор параллельными алгоритмами стандартной библиотеки:
+// строки rows (RowIndices(N)) раздаёт std::for_each(par_unseq), скалярное произведение строки -
+// std::transform_reduce(unseq). В libstdc++ параллельные политики исполняет TBB
+inline void ExecutionMultiplication(int N, const std::vector<int> &rows, const std::vector<double> &matrix,
+                                    const std::vector<double> &vector, std::vector<double> &resultVector) {
+    std::for_each(std::execution::par_unseq, rows.begin(), rows.end(), [&](int i) {
+        const double *row = matrix.data() + static_cast<size_t>(i) * N;
+        resultVector[i] = std::transform_reduce(std::execution::unseq, row, row + N, vector.data(), 0.0);
+    });
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+// Умножение квадратных матриц C += A * B (N x N, хранение по строкам) с упаковкой панелей и блокировкой по кэшам.
+// C делится между потоками двумерной сеткой блоков; каждый поток сам упаковывает нужные ему панели A и B.
+namespace gemm {
+
+    // Векторное расширение GCC/Clang шириной в регистр: с AVX - ymm (4 double), иначе - xmm SSE2 (2 double)
+#ifdef __AVX__
+    constexpr int Width = 4;
+#else
+    constexpr int Width = 2;
+#endif
+    typedef double Vector __attribute__((vector_size(Width * sizeof(double))));
+
+    // Размер микроядра: блок C из MR строк и NR столбцов живёт в регистрах (8 векторов)
+    constexpr int MR = 4;
+    constexpr int NR = 2 * Width;
+    // KC x NR - микропанель B, помещается в L1; MC x KC - упакованный блок A, помещается в L2
+    constexpr int KC = 256;
+    constexpr int MC = 96;
+    constexpr int NC = 2048;
+
+    inline Vector Load(const double *source) {
+        Vector value;
+        std::memcpy(&value, source, sizeof(value));
+        return value;
+    }
+
+    inline void Store(double *target, Vector value) {
+        std::memcpy(target, &value, sizeof(value));
+    }
+
+    // c[MR x NR] += a * b, где a - kc столбцов по MR чисел, b - kc строк по NR чисел.
+    // Неполный блок (mr < MR или nr < NR) считается целиком и прибавляется к C поэлементно
+    inline void MicroKernel(int kc, const double *a, const double *b, double *c, int ldc, int mr, int nr) {
+        Vector c00{}, c01{}, c10{}, c11{}, c20{}, c21{}, c30{}, c31{};
+        for (int p = 0; p < kc; ++p, a += MR, b += NR) {
+            const Vector b0 = Load(b), b1 = Load(b + Width);
+            c00 += a[0] * b0;
+            c01 += a[0] * b1;
+            c10 += a[1] * b0;
+            c11 += a[1] * b1;
+            c20 += a[2] * b0;
+            c21 += a[2] * b1;
+            c30 += a[3] * b0;
+            c31 += a[3] * b1;
+        }
+        const Vector sums[MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+        if (mr == MR && nr == NR) {
+            for (int i = 0; i < MR; ++i) {
+                Store(c + i * ldc, Load(c + i * ldc) + sums[i][0]);
+                Store(c + i * ldc + Width, Load(c + i * ldc + Width) + sums[i][1]);
+            }
+            return;
+        }
+        double tile[MR][NR];
+        for (int i = 0; i < MR; ++i) {
+            Store(tile[i], sums[i][0]);
+            Store(tile[i] + Width, sums[i][1]);
+        }
+        for (int i = 0; i < mr; ++i)
+            for (int j = 0; j < nr; ++j)
+                c[i * ldc + j] += tile[i][j];
+    }
+
+    // Блок A[rows x kc] -> полосы по MR строк, внутри полосы по столбцам; недостающие строки - нули
+    inline void PackA(const double *a, int lda, int rows, int kc, double *packed) {
+        for (int i = 0; i < rows; i += MR)
+            for (int p = 0; p < kc; ++p)
+                for (int r = 0; r < MR; ++r)
+                    *packed++ = i + r < rows ? a[(i + r) * lda + p] : 0;
+    }
+
+    // Блок B[kc x cols] -> полосы по NR столбцов, внутри полосы по строкам; недостающие столбцы - нули
+    inline void PackB(const double *b, int ldb, int kc, int cols, double *packed) {
+        for (int j = 0; j < cols; j += NR)
+            for (int p = 0; p < kc; ++p)
+                for (int s = 0; s < NR; ++s)
+                    *packed++ = j + s < cols ? b[p * ldb + j + s] : 0;
+    }
+
+    // Сетка rows x cols потоков, rows * cols = threads, как можно ближе к квадрату
+    inline void Grid(int threads, int &rows, int &cols) {
+        cols = 1;
+        for (int d = 1; d * d <= threads; ++d)
+            if (threads % d == 0)
+                cols = d;
+        rows = threads / cols;
+    }
+
+    // Часть C, приходящаяся на поток thread из threads: строки и столбцы сетки выровнены по MR и NR
+    inline void Multiply(int N, const double *A, const double *B, double *C, int thread, int threads) {
+        int gridRows, gridCols;
+        Grid(threads, gridRows, gridCols);
+        auto split = [N](int part, int parts, int step) {
+            const int blocks = (N + step - 1) / step;
+            return std::min(N, static_cast<int>(static_cast<long long>(blocks) * part / parts) * step);
+        };
+        const int r0 = split(thread / gridCols, gridRows, MR), r1 = split(thread / gridCols + 1, gridRows, MR);
+        const int c0 = split(thread % gridCols, gridCols, NR), c1 = split(thread % gridCols + 1, gridCols, NR);
+        if (r0 >= r1 || c0 >= c1)
+            return;
+
+        const int depth = std::min(KC, N);
+        std::vector<double> packedA((std::min(MC, r1 - r0) + MR - 1) / MR * MR * depth);
+        std::vector<double> packedB((std::min(NC, c1 - c0) + NR - 1) / NR * NR * depth);
+        for (int jc = c0; jc < c1; jc += NC) {
+            const int nc = std::min(NC, c1 - jc);
+            for (int pc = 0; pc < N; pc += KC) {
+                const int kc = std::min(KC, N - pc);
+                PackB(B + static_cast<size_t>(pc) * N + jc, N, kc, nc, packedB.data());
+                for (int ic = r0; ic < r1; ic += MC) {
+                    const int mc = std::min(MC, r1 - ic);
+                    PackA(A + static_cast<size_t>(ic) * N + pc, N, mc, kc, packedA.data());
+                    for (int jr = 0; jr < nc; jr += NR)
+                        for (int ir = 0; ir < mc; ir += MR)
+                            MicroKernel(kc, &packedA[ir * kc], &packedB[jr * kc],
+                                        C + static_cast<size_t>(ic + ir) * N + jc + jr, N,
+                                        std::min(MR, mc - ir), std::min(NR, nc - jr));
+                }
+            }
+        }
+    }
+
+    // Тройной цикл для сравнения: строки C делятся между потоками поровну
+    inline void MultiplyNaive(int N, const double *A, const double *B, double *C, int thread, int threads) {
+        const int lb = static_cast<int>(static_cast<long long>(N) * thread / threads);
+        const int ub = static_cast<int>(static_cast<long long>(N) * (thread + 1) / threads);
+        for (int i = lb; i < ub; ++i)
+            for (int j = 0; j < N; ++j) {
+                double sum{};
+                for (int k = 0; k < N; ++k)
+                    sum += A[static_cast<size_t>(i) * N + k] * B[static_cast<size_t>(k) * N + j];
+                C[static_cast<size_t>(i) * N + j] += sum;
+            }
+    }
+
+}
+
+#endif
@@ -4,52 +4,279 @@
 #include <algorithm>
 #include <functional>
 #include <chrono>
+#include <string>
+#include <memory>
+#include <new>
+#include <cmath>
 
-std::chrono::duration<double> Multiplication(int N, int threadAmount) {
+#include "thread_pool.hpp"
+#include "parallel.hpp"
+#include "gemm.hpp"
+
+// Диапазон строк потока; каждый описатель занимает свою кэш-линию
+struct alignas(64) Range {
+    int lb;
+    int ub;
+};
+
+// Память, выровненная по кэш-линии: с ней границы диапазонов строк, кратные 8, совпадают с границами линий
+template<typename T>
+struct CacheLineAllocator {
+    using value_type = T;
+
+    CacheLineAllocator() = default;
+
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(64)));
+    }
+
+    void deallocate(T *pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(64));
+    }
+
+    bool operator==(const CacheLineAllocator &) const = default;
+};
+
+// Способ запуска: новые потоки на каждый вызов (pool и team не заданы), ThreadPool или parallel::Team.
+// schedule и chunk используются только командой parallel::Team
+struct Runtime {
+    ThreadPool *pool{};
+    parallel::Team *team{};
+    parallel::Schedule schedule = parallel::Schedule::Static;
+    int chunk{};
+};
+
+// Выполняет task(i) для i = 0, ..., threadAmount - 1
+void ParallelRun(int threadAmount, const Runtime &runtime, const std::function<void(int)> &task) {
+    if (runtime.pool) {
+        runtime.pool->Run(task);
+        return;
+    }
+    if (runtime.team) {
+        runtime.team->Run(task);
+        return;
+    }
     std::vector<std::thread> threads(threadAmount);
-    std::vector<double> matrix(N * N);
+    for (int i = 0; i < threadAmount; ++i)
+        threads[i] = std::thread(task, i);
+    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+}
+
+// Диапазоны строк по потокам; размер диапазона кратен 8 строкам (64 байта результата), так что потоки
+// не пишут в одну кэш-линию resultVector. Последние диапазоны могут оказаться пустыми
+std::vector<Range> Ranges(int N, int threadAmount) {
+    const int line = 64 / sizeof(double);
+    const int itemsPerThread = ((N + threadAmount - 1) / threadAmount + line - 1) / line * line;
+    std::vector<Range> ranges(threadAmount);
+    for (int i = 0; i < threadAmount; ++i) {
+        ranges[i].lb = i * itemsPerThread;
+        ranges[i].ub = (i == threadAmount - 1) ? (N - 1) : std::min(ranges[i].lb + itemsPerThread - 1, N - 1);
+    }
+    return ranges;
+}
+
+// Среднее время одного из calls умножений матрицы на вектор; инициализация выполняется один раз.
+// kernel: register - сумма строки копится в четырёх независимых накопителях (регистрах, которые компилятор
+// может развернуть в SIMD) и записывается в resultVector один раз; naive - исходный цикл с resultVector[i] +=, перед которым
+// resultVector[i] обнуляется, чтобы повторные вызовы давали тот же результат.
+// С parallel::Team строки раздаются parallel::ParallelFor по расписанию runtime, иначе - диапазонами Ranges
+std::chrono::duration<double> Multiplication(int N, int threadAmount, const Runtime &runtime, int calls,
+                                             const std::string &kernel) {
+    std::vector<double> matrix(static_cast<size_t>(N) * N);
     std::vector<double> vector(N);
+    std::vector<double, CacheLineAllocator<double>> resultVector(N, 0);
 
-    int itemsPerThread = N / threadAmount;
-    for (int i = 0; i < threads.size(); ++i) { // инициализация
-        int lb = i * itemsPerThread;
-        int ub = (i == threads.size() - 1) ? (N - 1) : (lb + itemsPerThread - 1);
-        threads[i] = std::thread([](std::vector<double> &matrix, std::vector<double> &vector, int lb, int ub) {
-            for (int i = lb; i <= ub; ++i) {
-                for (int j = 0; j < vector.size(); ++j)
-                    matrix[i * vector.size() + j] = i + j;
-                vector[i] = i;
+    // Строки [lb, ub)
+    const std::function<void(int, int)> initialize = [&](int lb, int ub) {
+        for (int i = lb; i < ub; ++i) {
+            for (int j = 0; j < N; ++j)
+                matrix[static_cast<size_t>(i) * N + j] = i + j;
+            vector[i] = i;
+        }
+    };
+    const std::function<void(int, int)> naive = [&](int lb, int ub) {
+        for (int i = lb; i < ub; ++i) {
+            resultVector[i] = 0;
+            for (int j = 0; j < N; ++j) {
+                resultVector[i] += matrix[static_cast<size_t>(i) * N + j] * vector[j];
             }
-        }, std::ref(matrix), std::ref(vector), lb, ub);
-    }
-    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+        }
+    };
+    const std::function<void(int, int)> accumulate = [&](int lb, int ub) {
+        const double *x = vector.data();
+        for (int i = lb; i < ub; ++i) {
+            const double *row = matrix.data() + static_cast<size_t>(i) * N;
+            double sum0{}, sum1{}, sum2{}, sum3{};
+            int j = 0;
+            for (; j + 3 < N; j += 4) {
+                sum0 += row[j] * x[j];
+                sum1 += row[j + 1] * x[j + 1];
+                sum2 += row[j + 2] * x[j + 2];
+                sum3 += row[j + 3] * x[j + 3];
+            }
+            for (; j < N; ++j)
+                sum0 += row[j] * x[j];
+            resultVector[i] = (sum0 + sum1) + (sum2 + sum3);
+        }
+    };
+
+    const std::vector<Range> ranges = Ranges(N, threadAmount);
+    auto forRows = [&](const std::function<void(int, int)> &rows) {
+        if (runtime.team)
+            parallel::ParallelFor(*runtime.team, 0, N, rows, runtime.schedule, runtime.chunk);
+        else
+            ParallelRun(threadAmount, runtime, [&](int thread) {
+                rows(ranges[thread].lb, ranges[thread].ub + 1);
+            });
+    };
+    forRows(initialize); // инициализация
 
-    std::vector<double> resultVector(N, 0);
+    const std::function<void(int, int)> &rows = kernel == "naive" ? naive : accumulate;
     const auto start = std::chrono::steady_clock::now();
-    for (int i = 0; i < threads.size(); ++i) {
-        int lb = i * itemsPerThread;
-        int ub = (i == threads.size() - 1) ? (N - 1) : (lb + itemsPerThread - 1);
-        threads[i] = std::thread(
-                [&resultVector](const std::vector<double> &matrix, const std::vector<double> &vector, int lb, int ub) {
-                    for (int i = lb; i <= ub; ++i)
-                        for (int j = 0; j < vector.size(); ++j) {
-                            resultVector[i] += matrix[i * vector.size() + j] * vector[j];
-                        }
-                }, std::cref(matrix), std::cref(vector), lb, ub);
-    }
-    std::for_each(threads.begin(), threads.end(), std::mem_fn(&std::thread::join));
+    for (int call = 0; call < calls; ++call)
+        forRows(rows);
     const auto end = std::chrono::steady_clock::now();
 
-    return (end - start);
+    return (end - start) / calls;
+}
+
+// Среднее время вызова пустого задания: накладные расходы запуска потоков или пула
+std::chrono::duration<double> CallOverhead(int threadAmount, const Runtime &runtime, int calls) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int call = 0; call < calls; ++call)
+        ParallelRun(threadAmount, runtime, [](int) {});
+    return (std::chrono::steady_clock::now() - start) / calls;
+}
+
+// Умножение матриц N x N: блочный gemm::Multiply против тройного цикла на тех же потоках.
+// Печатает время и GFLOP/s обоих (2 N^3 операций) и наибольшее расхождение результатов
+void MatrixMultiplication(int N, int threadAmount, const Runtime &runtime) {
+    const size_t size = static_cast<size_t>(N) * N;
+    std::vector<double> A(size), B(size), blocked(size, 0), naive(size, 0);
+    for (size_t k = 0; k < size; ++k) { // целые значения: суммы точны при любом порядке сложения
+        A[k] = static_cast<double>((k / N + k % N) % 7) - 3;
+        B[k] = static_cast<double>((k / N * (k % N)) % 5) - 2;
+    }
+    auto measure = [&](auto multiply, std::vector<double> &C) {
+        const auto start = std::chrono::steady_clock::now();
+        ParallelRun(threadAmount, runtime, [&](int thread) {
+            multiply(N, A.data(), B.data(), C.data(), thread, threadAmount);
+        });
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    };
+    const auto blockedTime = measure(gemm::Multiply, blocked);
+    const auto naiveTime = measure(gemm::MultiplyNaive, naive);
+    double difference{};
+    for (size_t k = 0; k < size; ++k)
+        difference = std::max(difference, std::abs(blocked[k] - naive[k]));
+    const double operations = 2.0 * N * N * N;
+    std::cout << std::fixed << "blocked: " << blockedTime << ", " << operations / blockedTime.count() / 1e9
+              << " GFLOP/s" << std::endl;
+    std::cout << "naive: " << naiveTime << ", " << operations / naiveTime.count() / 1e9 << " GFLOP/s" << std::endl;
+    std::cout << "speedup: " << naiveTime / blockedTime << std::endl;
+    std::cout << "max difference: " << difference << std::endl;
+}
+
+int PinError(const std::string &affinity) {
+    std::cout << "Cannot pin threads to processors: " << affinity << std::endl;
+    return 1;
 }
 
+// task3.1 N threads [--runtime spawn|pool|jthread] [--affinity compact|scatter|cpu,cpu,...] [--calls k]
+//                   [--kernel register|naive|compare] [--schedule static|dynamic|guided[,chunk]]
+//                   [--operation gemv|gemm]
+// gemm - умножение матриц (gemm.hpp); ширина векторов микроядра берётся из набора инструкций сборки,
+// для AVX2 и FMA собирать с -O3 -march=native.
+// compare печатает время обоих ядер и ускорение для 1, 2, 4, ..., threads потоков.
+// --affinity - только для pool, --schedule - только для jthread (parallel::ParallelFor)
 int main(int argc, char **argv) {
-    if (argc != 3)
+    if (argc < 3 || argc % 2 == 0)
         return 1;
     int N = atoi(argv[1]);
     int threadAmount = atoi(argv[2]);
-    auto duration = Multiplication(N, threadAmount);
+    if (N <= 0 || threadAmount <= 0)
+        return 1;
+    std::string runtime = "spawn", affinity, kernel = "register", schedule, operation = "gemv";
+    int calls = 1;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--runtime")
+            runtime = value;
+        else if (option == "--affinity")
+            affinity = value;
+        else if (option == "--kernel")
+            kernel = value;
+        else if (option == "--schedule")
+            schedule = value;
+        else if (option == "--operation")
+            operation = value;
+        else if (option == "--calls")
+            calls = atoi(value.c_str());
+        else
+            return 1;
+    }
+    if ((runtime != "spawn" && runtime != "pool" && runtime != "jthread") || calls <= 0 ||
+        (!affinity.empty() && runtime != "pool") || (!schedule.empty() && runtime != "jthread") ||
+        (kernel != "register" && kernel != "naive" && kernel != "compare") ||
+        (operation != "gemv" && operation != "gemm") || (operation == "gemm" && kernel == "compare"))
+        return 1;
+    Runtime settings;
+    if (!schedule.empty()) {
+        const std::string kind = schedule.substr(0, schedule.find(','));
+        if (schedule.find(',') != std::string::npos)
+            settings.chunk = atoi(schedule.c_str() + schedule.find(',') + 1);
+        if (kind == "dynamic")
+            settings.schedule = parallel::Schedule::Dynamic;
+        else if (kind == "guided")
+            settings.schedule = parallel::Schedule::Guided;
+        else if (kind != "static" || settings.chunk < 0)
+            return 1;
+        // Порции dynamic и guided по умолчанию - кэш-линия результата
+        if (settings.schedule != parallel::Schedule::Static && settings.chunk == 0)
+            settings.chunk = 64 / sizeof(double);
+    }
+    std::vector<int> cpus;
+    if (!affinity.empty() && (cpus = AffinityMap(affinity, threadAmount)).empty())
+        return 1;
+    if (kernel == "compare") {
+        std::cout << "threads, naive (s), register (s), speedup" << std::endl;
+        for (int count = 1; count <= threadAmount; count *= 2) {
+            std::unique_ptr<ThreadPool> pool;
+            std::unique_ptr<parallel::Team> team;
+            if (runtime == "pool" && !(pool = std::make_unique<ThreadPool>(count, cpus))->Pinned())
+                return PinError(affinity);
+            if (runtime == "jthread")
+                team = std::make_unique<parallel::Team>(count);
+            Runtime current = settings;
+            current.pool = pool.get();
+            current.team = team.get();
+            auto naive = Multiplication(N, count, current, calls, "naive");
+            auto accumulate = Multiplication(N, count, current, calls, "register");
+            std::cout << count << ", " << std::fixed << naive.count() << ", " << accumulate.count() << ", "
+                      << naive / accumulate << std::endl;
+        }
+        return 0;
+    }
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<parallel::Team> team;
+    if (runtime == "pool" && !(pool = std::make_unique<ThreadPool>(threadAmount, cpus))->Pinned())
+        return PinError(affinity);
+    if (runtime == "jthread")
+        team = std::make_unique<parallel::Team>(threadAmount);
+    settings.pool = pool.get();
+    settings.team = team.get();
+    if (operation == "gemm") {
+        MatrixMultiplication(N, threadAmount, settings);
+        return 0;
+    }
+    auto duration = Multiplication(N, threadAmount, settings, calls, kernel);
     std::cout << std::fixed << duration << std::endl;
+    if (calls > 1)
+        std::cout << "call overhead: " << CallOverhead(threadAmount, settings, calls) << std::endl;
 
     return 0;
 }
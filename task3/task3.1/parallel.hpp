@@ -0,0 +1,168 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <barrier>
+#include <functional>
+#include <algorithm>
+#include <utility>
+
+// Параллельные циклы на стандартных примитивах C++20 без OpenMP
+namespace parallel {
+
+    // static - непрерывные блоки (chunk 0) или порции chunk по кругу; dynamic - порции chunk из общего
+    // атомарного счётчика; guided - как dynamic, но порция - остаток / (2 * потоков), не меньше chunk
+    enum class Schedule {
+        Static,
+        Dynamic,
+        Guided
+    };
+
+    // Команда из threadAmount потоков std::jthread, создаётся один раз. Run выполняет job(thread) на всех потоках:
+    // начало и конец задания - фазы барьеров start и finish, в которых участвует и вызывающий поток.
+// Отдельно ждать запуска потоков не нужно: первый Run (или деструктор) всё равно ждёт их на барьере start.
+    class Team {
+    public:
+        explicit Team(int threadAmount) : start(threadAmount + 1), finish(threadAmount + 1) {
+            for (int i = 0; i < threadAmount; ++i)
+                workers.emplace_back([this, i](std::stop_token stop) {
+                    while (true) {
+                        start.arrive_and_wait();
+                        if (stop.stop_requested())
+                            return;
+                        (*job)(i);
+                        finish.arrive_and_wait();
+                    }
+                });
+        }
+
+        ~Team() {
+            for (std::jthread &worker: workers)
+                worker.request_stop();
+            start.arrive_and_wait();
+        }
+
+        void Run(const std::function<void(int)> &function) {
+            job = &function;
+            start.arrive_and_wait();
+            finish.arrive_and_wait();
+        }
+
+        int Size() const {
+            return static_cast<int>(workers.size());
+        }
+
+    private:
+        std::barrier<> start;
+        std::barrier<> finish;
+        const std::function<void(int)> *job{};
+        std::vector<std::jthread> workers;
+    };
+
+    // Раздача полуинтервалов [lb, ub) из [begin, end) одному потоку по расписанию; next - общий счётчик
+    // для dynamic и guided
+    template<typename Body>
+    void Chunks(int thread, int threads, int begin, int end, Schedule schedule, int chunk, std::atomic<int> &next,
+                Body &body) {
+        if (schedule == Schedule::Static) {
+            if (chunk <= 0) {
+                const long long length = end - begin;
+                const int lb = begin + static_cast<int>(length * thread / threads);
+                const int ub = begin + static_cast<int>(length * (thread + 1) / threads);
+                if (lb < ub)
+                    body(lb, ub);
+                return;
+            }
+            for (long long lb = begin + static_cast<long long>(thread) * chunk; lb < end;
+                 lb += static_cast<long long>(threads) * chunk)
+                body(static_cast<int>(lb), static_cast<int>(std::min<long long>(lb + chunk, end)));
+            return;
+        }
+        chunk = std::max(chunk, 1);
+        while (true) {
+            int lb, size = chunk;
+            if (schedule == Schedule::Dynamic)
+                lb = next.fetch_add(chunk, std::memory_order_relaxed);
+            else {
+                lb = next.load(std::memory_order_relaxed);
+                do {
+                    if (lb >= end)
+                        break;
+                    size = std::max(chunk, (end - lb) / (2 * threads));
+                } while (!next.compare_exchange_weak(lb, lb + size, std::memory_order_relaxed));
+            }
+            if (lb >= end)
+                return;
+            body(lb, std::min(lb + size, end));
+        }
+    }
+
+    // body(lb, ub) для полуинтервалов, покрывающих [begin, end)
+    template<typename Body>
+    void ParallelFor(Team &team, int begin, int end, Body body, Schedule schedule = Schedule::Static,
+                     int chunk = 0) {
+        std::atomic<int> next{begin};
+        team.Run([&](int thread) {
+            Chunks(thread, team.Size(), begin, end, schedule, chunk, next, body);
+        });
+    }
+
+    // Свёртка: каждый поток накапливает partial = body(lb, ub, partial) по своим полуинтервалам, начиная
+    // с identity, затем частичные результаты объединяются combine в порядке номеров потоков
+    template<typename T, typename Body, typename Combine>
+    T ParallelReduce(Team &team, int begin, int end, T identity, Body body, Combine combine,
+                     Schedule schedule = Schedule::Static, int chunk = 0) {
+        struct alignas(64) Partial {
+            T value;
+        };
+        std::vector<Partial> partials(team.Size(), Partial{identity});
+        std::atomic<int> next{begin};
+        team.Run([&](int thread) {
+            T partial = identity;
+            auto accumulate = [&](int lb, int ub) {
+                partial = body(lb, ub, partial);
+            };
+            Chunks(thread, team.Size(), begin, end, schedule, chunk, next, accumulate);
+            partials[thread].value = partial;
+        });
+        T result = identity;
+        for (const Partial &partial: partials)
+            result = combine(result, partial.value);
+        return result;
+    }
+
+    // Включающий префиксный результат output[i] = input[0] op ... op input[i] (op ассоциативна, identity - её
+    // нейтральный элемент). Два прохода по статическим блокам: сумма блока, затем проход с префиксом
+    // предыдущих блоков; префиксы блоков считает функция завершения фазы std::barrier
+    template<typename T, typename Op = std::plus<T>>
+    void ParallelScan(Team &team, const T *input, T *output, int n, T identity = T{}, Op op = Op{}) {
+        const int threads = team.Size();
+        struct alignas(64) Block {
+            T value;
+        };
+        std::vector<Block> blocks(threads, Block{identity});
+        auto prefixes = [&]() noexcept {
+            T running = identity;
+            for (Block &block: blocks)
+                running = op(running, std::exchange(block.value, running));
+        };
+        std::barrier phase(threads, prefixes);
+        team.Run([&](int thread) {
+            const int lb = static_cast<int>(static_cast<long long>(n) * thread / threads);
+            const int ub = static_cast<int>(static_cast<long long>(n) * (thread + 1) / threads);
+            T sum = identity;
+            for (int i = lb; i < ub; ++i)
+                sum = op(sum, input[i]);
+            blocks[thread].value = sum;
+            phase.arrive_and_wait();
+            T running = blocks[thread].value;
+            for (int i = lb; i < ub; ++i)
+                output[i] = running = op(running, input[i]);
+        });
+    }
+
+}
+
+#endif
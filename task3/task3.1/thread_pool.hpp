@@ -0,0 +1,116 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <sstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Пул потоков, создаваемых один раз: Run выполняет task(i) на каждом потоке пула и ждёт завершения всех.
+// Потоки ждут нового задания на atomic::wait, так что вызов не создаёт потоков и не захватывает мьютексов.
+// Если задан список процессоров, поток i закрепляется за cpus[i % cpus.size()] до того, как начнёт работу:
+// потоки ждут сигнала started, который конструктор подаёт после закрепления. Pinned() - удалось ли закрепить все.
+class ThreadPool {
+public:
+    ThreadPool(int threadAmount, const std::vector<int> &cpus = {}) {
+        for (int i = 0; i < threadAmount; ++i) {
+            workers.emplace_back([this, i] { Work(i); });
+            if (!cpus.empty() && !Pin(workers.back(), cpus[i % cpus.size()]))
+                pinned = false;
+        }
+        started = true;
+        started.notify_all();
+    }
+
+    ~ThreadPool() {
+        stop = true;
+        generation.fetch_add(1);
+        generation.notify_all();
+        for (std::thread &worker: workers)
+            worker.join();
+    }
+
+    void Run(const std::function<void(int)> &function) {
+        task = &function;
+        remaining = static_cast<int>(workers.size());
+        generation.fetch_add(1);
+        generation.notify_all();
+        for (int left = remaining; left != 0; left = remaining)
+            remaining.wait(left);
+    }
+
+    int Size() const {
+        return static_cast<int>(workers.size());
+    }
+
+    bool Pinned() const {
+        return pinned;
+    }
+
+    static bool Pin(std::thread &thread, int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+private:
+    void Work(int index) {
+        started.wait(false);
+        unsigned seen = 0;
+        while (true) {
+            generation.wait(seen);
+            seen = generation;
+            if (stop)
+                return;
+            (*task)(index);
+            if (remaining.fetch_sub(1) == 1)
+                remaining.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    const std::function<void(int)> *task{};
+    std::atomic<unsigned> generation{};
+    std::atomic<int> remaining{};
+    std::atomic<bool> stop{};
+    std::atomic<bool> started{};
+    bool pinned{true};
+};
+
+// Процессоры для threadAmount потоков: compact - подряд (0, 1, 2, ...), scatter - равномерно по всем
+// процессорам, иначе - явный список через запятую. Пустой результат - неверное описание.
+inline std::vector<int> AffinityMap(const std::string &kind, int threadAmount) {
+    const int cpuAmount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> cpus;
+    if (kind == "compact")
+        for (int i = 0; i < threadAmount; ++i)
+            cpus.push_back(i % cpuAmount);
+    else if (kind == "scatter")
+        for (int i = 0; i < threadAmount; ++i)
+            cpus.push_back(threadAmount <= cpuAmount ? i * cpuAmount / threadAmount : i % cpuAmount);
+    else {
+        std::stringstream stream(kind);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (item.empty() || item.find_first_not_of("0123456789") != std::string::npos)
+                return {};
+            cpus.push_back(std::stoi(item));
+        }
+    }
+    return cpus;
+}
+
+#endif
@@ -7,7 +7,14 @@
 #include <fstream>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+
+#include "queue.hpp"
 
 enum Task {
     Sin,
@@ -74,26 +81,34 @@ namespace Test {
     }
 }
 
-template<typename T>
+// Queue - очередь задач (queue.hpp): MutexQueue или LockFreeQueue. Сервер засыпает на atomic::wait флага sleeping,
+// только найдя очередь пустой дважды; клиент будит его лишь при поднятом флаге, а не на каждую задачу.
+// После Stop сервер дорабатывает оставшиеся в очереди задачи и завершается
+template<typename T, typename Queue = MutexQueue<std::tuple<Task, T, T>>>
 class Server {
 private:
-    std::mutex queueMutex;
-    std::mutex pauseMutex;
-    std::queue<std::tuple<Task, T, T>> taskQueue;
-    size_t taskId;
+    Queue taskQueue;
+    std::atomic<size_t> taskId;
+    std::atomic<bool> sleeping;
     std::vector<std::tuple<std::string, T, T, T>> results;
     std::jthread serverThread;
-    std::condition_variable cv;
 
     void Work(const std::stop_token &stopToken) {
-        while (!stopToken.stop_requested()) {
-            if (taskQueue.empty()) {
-                std::unique_lock lck(queueMutex);
-                cv.wait(lck);
+        std::tuple<Task, T, T> task;
+        while (true) {
+            if (!taskQueue.Pop(task)) {
+                // Флаг поднимается до повторной проверки очереди: клиент, положивший задачу после неё,
+                // увидит флаг (барьеры seq_cst с обеих сторон) и разбудит сервер
+                sleeping.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!taskQueue.Pop(task)) {
+                    if (stopToken.stop_requested())
+                        return;
+                    sleeping.wait(true);
+                    continue;
+                }
+                sleeping.store(false);
             }
-            std::unique_lock lck(queueMutex);
-            std::tuple<Task, T, T> task(taskQueue.front());
-            lck.unlock();
             T x = get<1>(task);
             T y = get<2>(task);
             switch (get<0>(task)) {
@@ -107,32 +122,38 @@ private:
                     results.emplace_back("Pow", fun_pow(x, y), x, y);
                     break;
             }
-            std::lock_guard guard(queueMutex);
-            taskQueue.pop();
         }
     }
 
 public:
     Server() :
             taskId{},
+            sleeping{},
             serverThread{} {}
 
     void Start() {
-        serverThread = std::jthread(&Server::Work, this);
+        serverThread = std::jthread([this](std::stop_token stopToken) {
+            Work(stopToken);
+        });
     }
 
     void Stop() {
         serverThread.request_stop();
+        sleeping.store(false);
+        sleeping.notify_one();
     }
 
     void Join() {
         serverThread.join();
     }
 
+    // Если ограниченная очередь заполнена, клиент ждёт, пока сервер её разгрузит
     size_t AddTask(Task taskType, T x, T y) {
-        std::lock_guard guard(queueMutex);
-        taskQueue.emplace(taskType, x, y);
-        cv.notify_one();
+        while (!taskQueue.Push(std::tuple<Task, T, T>(taskType, x, y)))
+            std::this_thread::yield();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false))
+            sleeping.notify_one();
         return taskId++;
     }
 
@@ -145,18 +166,23 @@ public:
     }
 };
 
-
-template<typename T>
+// Клиент замеряет время каждого вызова AddTask (задержку постановки в очередь)
+template<typename T, typename Queue = MutexQueue<std::tuple<Task, T, T>>>
 class Client {
 public:
-    Client(Server<T> &server, Task taskType) :
-            server((Server<T> &) server),
+    Client(Server<T, Queue> &server, Task taskType) :
+            server((Server<T, Queue> &) server),
             taskType(taskType) {}
 
     void Start(int N) {
+        latencies.reserve(N);
         thread = std::thread([N, this] {
-            for (int i = 0; i < N; ++i)
-                server.AddTask(taskType, rand() % 100, rand() % 4);
+            for (int i = 0; i < N; ++i) {
+                const T x = rand() % 100, y = rand() % 4;
+                const auto start = std::chrono::steady_clock::now();
+                server.AddTask(taskType, x, y);
+                latencies.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
         });
     }
 
@@ -164,28 +190,36 @@ public:
         thread.join();
     }
 
+    const std::vector<double> &Latencies() const {
+        return latencies;
+    }
+
 private:
-    Server<T> &server;
+    Server<T, Queue> &server;
     Task taskType;
     std::thread thread;
+    std::vector<double> latencies;
 };
 
-template<typename T>
-std::vector<std::tuple<std::string, T, T, T>> Process() {
-    auto server = std::make_shared<Server<T>>();
-    auto client_sin = std::make_unique<Client<T>>(*server, Sin);
-    auto client_sqrt = std::make_unique<Client<T>>(*server, Sqrt);
-    auto client_pow = std::make_unique<Client<T>>(*server, Pow);
+// clientAmount клиентов по N задач, типы задач по кругу Sin, Sqrt, Pow.
+// В latencies, если задан, добавляются задержки постановки в очередь всех клиентов
+template<typename T, typename Queue = MutexQueue<std::tuple<Task, T, T>>>
+std::vector<std::tuple<std::string, T, T, T>> Process(int clientAmount = 3, int N = 10000,
+                                                      std::vector<double> *latencies = nullptr) {
+    auto server = std::make_shared<Server<T, Queue>>();
+    std::vector<std::unique_ptr<Client<T, Queue>>> clients;
+    for (int i = 0; i < clientAmount; ++i)
+        clients.push_back(std::make_unique<Client<T, Queue>>(*server, static_cast<Task>(i % 3)));
 
     server->Start();
 
-    client_sin->Start(10000);
-    client_sqrt->Start(10000);
-    client_pow->Start(10000);
-
-    client_sin->Join();
-    client_sqrt->Join();
-    client_pow->Join();
+    for (auto &client: clients)
+        client->Start(N);
+    for (auto &client: clients) {
+        client->Join();
+        if (latencies)
+            latencies->insert(latencies->end(), client->Latencies().begin(), client->Latencies().end());
+    }
 
     server->Stop();
     server->Join();
@@ -193,9 +227,47 @@ std::vector<std::tuple<std::string, T, T, T>> Process() {
     return std::move(server->GetResult());
 }
 
-int main() {
+// Задачи в секунду (от запуска клиентов до обработки всех задач) и 99-й перцентиль задержки AddTask
+// для 1, 2, 4, ..., maxClients клиентов
+template<typename Queue>
+void Benchmark(const std::string &name, int maxClients, int N) {
+    for (int clientAmount = 1; clientAmount <= maxClients; clientAmount *= 2) {
+        std::vector<double> latencies;
+        const auto start = std::chrono::steady_clock::now();
+        const size_t processed = Process<double, Queue>(clientAmount, N, &latencies).size();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::nth_element(latencies.begin(), latencies.begin() + latencies.size() * 99 / 100, latencies.end());
+        std::cout << name << ", " << clientAmount << ", " << std::fixed << std::setprecision(0)
+                  << processed / elapsed.count() << ", " << latencies[latencies.size() * 99 / 100] * 1e9;
+        if (processed != static_cast<size_t>(clientAmount) * N)
+            std::cout << " (lost " << static_cast<size_t>(clientAmount) * N - processed << " tasks)";
+        std::cout << std::endl;
+    }
+}
+
+// task3.2 [--queue mutex|lockfree] - обработка задач трёх клиентов с проверкой результатов;
+// task3.2 --benchmark maxClients [tasksPerClient] - сравнение очередей при росте числа клиентов
+int main(int argc, char **argv) {
     std::srand(std::time(nullptr));
-    auto res = Process<double>();
+    const std::string option = argc > 1 ? argv[1] : "";
+    if (option == "--benchmark") {
+        if (argc != 3 && argc != 4)
+            return 1;
+        const int maxClients = atoi(argv[2]);
+        const int N = argc == 4 ? atoi(argv[3]) : 100000;
+        if (maxClients <= 0 || N <= 0)
+            return 1;
+        std::cout << "queue, clients, tasks/s, p99 enqueue latency (ns)" << std::endl;
+        Benchmark<MutexQueue<std::tuple<Task, double, double>>>("mutex", maxClients, N);
+        Benchmark<LockFreeQueue<std::tuple<Task, double, double>>>("lockfree", maxClients, N);
+        return 0;
+    }
+    if (argc != 1 && (argc != 3 || option != "--queue" ||
+                      (std::string(argv[2]) != "mutex" && std::string(argv[2]) != "lockfree")))
+        return 1;
+    auto res = argc == 3 && std::string(argv[2]) == "lockfree"
+               ? Process<double, LockFreeQueue<std::tuple<Task, double, double>>>()
+               : Process<double>();
     std::ofstream outputFile;
     outputFile.open("output.txt");
     outputFile << std::fixed << std::setprecision(5);
@@ -0,0 +1,103 @@
+#ifndef QUEUE_HPP
+#define QUEUE_HPP
+
+#include <queue>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Очереди задач для Server: Push кладёт элемент (false - очередь заполнена), Pop достаёт (false - пуста).
+// Обе безопасны для нескольких производителей и нескольких потребителей.
+
+// Неограниченная очередь std::queue под мьютексом
+template<typename Item>
+class MutexQueue {
+public:
+    bool Push(const Item &item) {
+        std::lock_guard guard(mutex);
+        queue.push(item);
+        return true;
+    }
+
+    bool Pop(Item &item) {
+        std::lock_guard guard(mutex);
+        if (queue.empty())
+            return false;
+        item = queue.front();
+        queue.pop();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::queue<Item> queue;
+};
+
+// Ограниченная очередь без блокировок (кольцевой буфер Вьюкова). У каждой ячейки свой номер sequence:
+// ячейка свободна для записи с номером pos, если sequence == pos, и готова к чтению, если sequence == pos + 1.
+// Производители и потребители занимают номера сравнением с обменом на enqueuePosition и dequeuePosition,
+// которые лежат в разных кэш-линиях. Capacity - степень двойки
+template<typename Item, size_t Capacity = 1 << 14>
+class LockFreeQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    LockFreeQueue() : cells(Capacity) {
+        for (size_t i = 0; i < Capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool Push(const Item &item) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & (Capacity - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (difference < 0)
+                return false;
+            else
+                position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+        cell->item = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(Item &item) {
+        size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & (Capacity - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (difference == 0) {
+                if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (difference < 0)
+                return false;
+            else
+                position = dequeuePosition.load(std::memory_order_relaxed);
+        }
+        item = cell->item;
+        cell->sequence.store(position + Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Item item;
+    };
+
+    std::vector<Cell> cells;
+    alignas(64) std::atomic<size_t> enqueuePosition{};
+    alignas(64) std::atomic<size_t> dequeuePosition{};
+    char padding[64 - sizeof(std::atomic<size_t>)]{};
+};
+
+#endif